@@ -37,6 +37,7 @@ CPARSER_BIN = "cparser"
 # Global vars
 
 fuzzer_options = None
+firmsmith_server = None
 optimizations = []
 now = None
 current_report = None
@@ -425,23 +426,59 @@ def get_firmsmith_args_as_string(args):
     return s
 
 
-def firmsmith_generate_ir_graph(args):
-    bin = FIRMSMITH_BIN
-    args = [bin] + args.split()
-    devnull = open(os.devnull, 'w')
+class FirmsmithServer:
+    """
+    Firmsmith running in --server mode: libFirm is initialized once and
+    every graph is generated by a child forked from the server.
+    """
+
+    def __init__(self, timeout):
+        self.args = [FIRMSMITH_BIN, '--server', '--timeout', str(timeout)]
+        self.start()
 
-    def run_firmsmith():
+    def start(self):
+        LOG.info(" ".join(self.args))
+        self.process = subprocess.Popen(self.args,
+            stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+
+    def restart(self):
+        LOG.error("firmsmith server died, restarting it")
         try:
-            LOG.info(" ".join(args))
-            process = subprocess.Popen(args, stdout=devnull, stderr=subprocess.PIPE)
-            (stdoutdata, stderrdata) = process.communicate()
-            if process.returncode != None and process.returncode != 0:
-                raise CalledProcessError(process.returncode, stderrdata)
-        except TimeoutError as e:
-            process.kill()
-            raise e
+            self.process.stdin.close()
+        except IOError:
+            pass
+        self.process.wait()
+        self.start()
+
+    def generate(self, args):
+        LOG.info("firmsmith request: %s" % args)
+        try:
+            self.process.stdin.write(args.strip() + '\n')
+            self.process.stdin.flush()
+            reply = self.process.stdout.readline()
+        except IOError:
+            reply = ''
+        if reply == '':
+            # No reply at all: the server itself is gone, not only the child
+            self.restart()
+            raise CalledProcessError(-1, "firmsmith server died")
+        reply = reply.strip()
+        if reply == 'ok':
+            return
+        elif reply.startswith('exit '):
+            raise CalledProcessError(int(reply.split()[1]))
+        elif reply.startswith('signal '):
+            raise CalledProcessError(-int(reply.split()[1]))
+        else:
+            raise CalledProcessError(-1, "unexpected firmsmith server reply: %s" % reply)
+
+    def close(self):
+        self.process.stdin.close()
+        self.process.wait()
 
-    set_timeout(5, run_firmsmith)
+
+def firmsmith_generate_ir_graph(args):
+    firmsmith_server.generate(args)
 
 # Cparser
 
@@ -599,7 +636,9 @@ def check_ir_graph(debugger, report):
 def fuzz(n):
     global fuzzer_options
     global current_report
+    global firmsmith_server
     debugger = get_debugger()
+    firmsmith_server = FirmsmithServer(timeout=5)
     for i in range(n):
         for firmsmith_option in fuzzer_options['firmsmith_options']:
             report = Report()
@@ -609,9 +648,11 @@ def fuzz(n):
             args.update({'strid': report.strid})
             report.args = get_firmsmith_args_as_string(args) + ' ' + firmsmith_option
             try:
-                firmsmith_generate_ir_graph(report.args)
-                LOG.info("mv *%s.{vcg,ir} %s" % (report.strid, REPORT_DIR))
-                subprocess.call('bash -c "mv *%s.{vcg,ir} %s"' % (report.strid, REPORT_DIR), shell=True)
+                # VCG files are only rebuilt from the .ir when a report is written.
+                # cparser reads the IR from a path, so it is exported straight
+                # into the report directory rather than streamed.
+                ir_file = '%s/%s.ir' % (REPORT_DIR, report.strid)
+                firmsmith_generate_ir_graph(report.args + ' --dump=none --ir-out ' + ir_file)
 
                 check_ir_graph(debugger, report)
                 if report.is_bug_report():
@@ -621,6 +662,7 @@ def fuzz(n):
                         report_file.write(str(report).replace('bugreports', 'bugreports/' + identifier))
                         print("\nReport was written to %s (%d timeouts, %d aborts, %d successes)"  % \
                             (filename.replace('reports/','reports/'+identifier+'/'), len(report.timeouts), len(report.aborts), len(report.successes)))
+                    subprocess.call([FIRMSMITH_BIN, '--dump-from-ir', '%s.ir' % report.strid], cwd=REPORT_DIR)
                     command = """bash -c '
                         REPORT_DIR=%s;
                         STRID=%s;
@@ -634,12 +676,13 @@ def fuzz(n):
                     LOG.info(command)
                     subprocess.call(command, shell=True)
                 else:
-                    LOG.info("rm %s/*%s.{vcg,ir}" % (REPORT_DIR, report.strid))
-                    subprocess.call('bash -c "rm %s/*%s.{vcg,ir}"' % (REPORT_DIR, report.strid), shell=True)
+                    LOG.info("rm %s" % ir_file)
+                    os.remove(ir_file)
 
-            except CalledProcessError, TimeoutError:
+            except (CalledProcessError, TimeoutError):
                 LOG.error("Could not generate ir graph with arguments %s" % \
                     report.args)
+    firmsmith_server.close()
 
 
 if __name__ == '__main__':
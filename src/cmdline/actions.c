@@ -4,10 +4,13 @@
  */
 #include "actions.h"
 
+#include <errno.h>
 #include <libfirm/firm.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "parameters.h"
 #include "version.h"
 #include <revision.h>
 
@@ -42,3 +45,55 @@ int action_version_short(const char *argv0)
 	       FIRMSMITH_MAJOR, FIRMSMITH_MINOR, FIRMSMITH_PATCHLEVEL);
 	return EXIT_SUCCESS;
 }
+
+/**
+ * Imports the IR read from in into a separate irp and dumps its graphs as
+ * VCG files with the given suffix. The current irp is left untouched.
+ */
+int dump_ir_stream(FILE *in, const char *input_name, const char *suffix)
+{
+	ir_prog *cur_irp  = get_irp();
+	ir_prog *dump_irp = new_ir_prog("dump");
+	set_irp(dump_irp);
+
+	int ret = EXIT_SUCCESS;
+	if (ir_import_file(in, input_name) != 0) {
+		fprintf(stderr, "couldn't import %s\n", input_name);
+		ret = EXIT_FAILURE;
+	} else {
+		dump_all_ir_graphs(suffix);
+	}
+
+	free_ir_prog();
+	set_irp(cur_irp);
+	return ret;
+}
+
+int dump_ir_file(const char *ir_file_name, const char *suffix)
+{
+	FILE *in = fopen(ir_file_name, "r");
+	if (in == NULL) {
+		fprintf(stderr, "couldn't open %s: %s\n", ir_file_name, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	int ret = dump_ir_stream(in, ir_file_name, suffix);
+	fclose(in);
+	return ret;
+}
+
+int action_dump_from_ir(const char *argv0)
+{
+	(void)argv0;
+	// Name the dumps like the generator did: <strid>.ir gets suffix <strid>
+	const char *file_name = fs_params.run.dump_from_ir;
+	const char *base_name = strrchr(file_name, '/');
+	base_name = base_name == NULL ? file_name : base_name + 1;
+
+	char   suffix[256];
+	size_t len = strlen(base_name);
+	if (len > 3 && strcmp(base_name + len - 3, ".ir") == 0) {
+		len -= 3;
+	}
+	snprintf(suffix, sizeof suffix, "%.*s", (int)len, base_name);
+	return dump_ir_file(file_name, suffix);
+}
@@ -5,8 +5,16 @@
 #ifndef ACTIONS_H
 #define ACTIONS_H
 
+#include <stdio.h>
+
 int action_version(const char *argv0);
 
 int action_version_short(const char *argv0);
 
+int action_dump_from_ir(const char *argv0);
+
+int dump_ir_file(const char *ir_file_name, const char *suffix);
+
+int dump_ir_stream(FILE *in, const char *input_name, const char *suffix);
+
 #endif
@@ -0,0 +1,127 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "fanout.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <libfirm/adt/array.h>
+
+#include "parameters.h"
+#include "../adt/error.h"
+#include "../lib/optimizations.h"
+
+/**
+ * Record sent from a fan-out child to its parent.
+ */
+typedef struct fanout_result_t {
+	int         valid;
+	opt_stats_t stats;
+} fanout_result_t;
+
+/**
+ * Runs inside the forked child: applies the pass and reports the result.
+ */
+static void fan_out_child(size_t opt, bool measure, int fd)
+{
+	dup2(STDERR_FILENO, STDOUT_FILENO);
+	if (fs_params.run.timeout > 0)
+		alarm(fs_params.run.timeout);
+
+	fanout_result_t result;
+	memset(&result, 0, sizeof(result));
+	result.valid = apply_opt(opt, measure ? &result.stats : NULL);
+	if (write(fd, &result, sizeof(result)) != (ssize_t)sizeof(result))
+		_exit(EXIT_FAILURE);
+	_exit(EXIT_SUCCESS);
+}
+
+/**
+ * Forks a child applying a single pass and waits for it.
+ * @param status Receives the wait status of the child
+ * @return true if the child sent back its result
+ */
+static bool fork_opt_child(size_t opt, bool measure, fanout_result_t *result,
+                           int *status)
+{
+	int fds[2];
+	if (pipe(fds) < 0)
+		panic("pipe failed: %s", strerror(errno));
+
+	fflush(NULL);
+	pid_t pid = fork();
+	if (pid < 0) {
+		panic("fork failed: %s", strerror(errno));
+	} else if (pid == 0) {
+		close(fds[0]);
+		fan_out_child(opt, measure, fds[1]);
+	}
+	close(fds[1]);
+
+	bool has_result = read(fds[0], result, sizeof(*result)) == (ssize_t)sizeof(*result);
+	close(fds[0]);
+
+	if (waitpid(pid, status, 0) < 0)
+		panic("waitpid failed: %s", strerror(errno));
+	return has_result;
+}
+
+/**
+ * Tests a single pass in a child and prints its outcome.
+ * @return true if the pass produced valid graphs
+ */
+static bool fan_out_opt(size_t opt, FILE *stats_out)
+{
+	fanout_result_t result;
+	int             status;
+	bool has_result = fork_opt_child(opt, stats_out != NULL, &result, &status);
+
+	if (has_result && stats_out != NULL)
+		print_opt_stats(stats_out, opt, &result.stats);
+
+	const char *name = get_opt_name(opt);
+	bool        ok   = false;
+	if (WIFSIGNALED(status)) {
+		printf("%s\tsignal %d\n", name, WTERMSIG(status));
+	} else if (WEXITSTATUS(status) != EXIT_SUCCESS || !has_result) {
+		printf("%s\texit %d\n", name, WEXITSTATUS(status));
+	} else if (!result.valid) {
+		printf("%s\tinvalid\n", name);
+	} else {
+		printf("%s\tok\n", name);
+		ok = true;
+	}
+	fflush(stdout);
+	return ok;
+}
+
+bool fan_out_measure(size_t opt, opt_stats_t *stats)
+{
+	fanout_result_t result;
+	int             status;
+	bool has_result = fork_opt_child(opt, true, &result, &status);
+	if (!has_result || !WIFEXITED(status)
+	    || WEXITSTATUS(status) != EXIT_SUCCESS || !result.valid)
+		return false;
+	*stats = result.stats;
+	return true;
+}
+
+int fan_out_opts(const char *passes, FILE *stats_out)
+{
+	size_t *list = parse_opt_list(passes);
+	if (list == NULL)
+		return EXIT_FAILURE;
+
+	bool ok = true;
+	for (size_t i = 0; i < ARR_LEN(list); ++i) {
+		ok &= fan_out_opt(list[i], stats_out);
+	}
+	DEL_ARR_F(list);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
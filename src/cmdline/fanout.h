@@ -0,0 +1,29 @@
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../lib/optimizations.h"
+
+/**
+ * Tests optimizations on the program currently held in memory.
+ *
+ * For every pass of the comma separated list (or every pass of the
+ * optimization table for "all") a child is forked, which applies the pass
+ * to its copy-on-write version of the program and verifies the graphs.
+ * The result is sent back over a pipe and printed as "<pass>\t<status>"
+ * with status being one of ok, invalid, exit <code> or signal <number>.
+ * If stats_out is given, the measurements of every pass are written to it.
+ *
+ * @return EXIT_SUCCESS if every pass produced valid graphs
+ */
+int fan_out_opts(const char *passes, FILE *stats_out);
+
+/**
+ * Measures a single pass of the optimization table in a forked child.
+ * @return false if the pass crashed or produced invalid graphs
+ */
+bool fan_out_measure(size_t opt, opt_stats_t *stats);
+
+#endif
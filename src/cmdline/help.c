@@ -86,11 +86,28 @@ static void print_help_basic(const char *argv0)
 	help_simple("--version",            "Display compiler version");
 	help_spaced("--seed", "n", 		    "Set seed for random graph generation");
 	help_spaced("--strid", "id",	    "Set identifier used in output file generation");
+	help_spaced("--count", "n",		    "Generate n programs <strid>-<i> seeded with <seed>+<i>");
+	help_spaced("--jobs", "n",		    "Expand the CFGs of the functions on n threads");
+	help_simple("--verify-determinism",	"Compare the IR hashes of two builds and a corpus record round trip");
+	help_simple("--server",			    "Read option lines from stdin and fork a generator per line");
+	help_spaced("--timeout", "n",		"Kill served generators running longer than n seconds");
+	help_equals("--passes", "list",	    "Run comma separated passes on the program, verifying after each");
+	help_spaced("--corpus-out", "file", "Append every generated program to a binary corpus");
+	help_spaced("--corpus-in", "file",	"Rebuild the programs of a binary corpus instead of generating");
+	help_spaced("--ir-out", "dest",		"Export the IR to a path ({strid} is substituted), - or fd:N");
+	help_equals("--dump", "mode",		"Dump VCG files: none, vcg (default) or on-failure");
+	help_spaced("--dump-from-ir", "file", "Dump VCG files for a saved .ir file and exit (named on pass crashes)");
+	help_spaced("--fan-out", "passes",	"Test each pass (comma separated or all) in a forked child");
+	help_spaced("--pass-stats", "file",	"Append per-pass timings and node counts as JSON lines (- = stdout)");
+	help_spaced("--sweep", "n",		    "Time passes over n doublings of cfg-size and cfb-size for the --count seeds");
+	help_spaced("--sweep-bound", "e",	"Flag passes whose cpu time / nodes^e exceeds the threshold (default 1.5)");
+	help_spaced("--sweep-threshold", "t", "Threshold for --sweep-bound (default 1e-6)");
 	help_f_yesno("-fstats", 		    "printing of generated graph statistics");
 	help_f_yesno("-ffunc-cycles", 	    "generation of cyclic function call graphs");
 	help_f_yesno("-ffunc-calls", 	    "generation of function calls");
 	help_f_yesno("-floops", 	    	"generation of loops in control flow graph");
 	help_f_yesno("-fmemory", 	    	"generation memory operations");
+	help_f_yesno("-fcompact", 	    	"removal of Id and dead nodes before export");
 	help_spaced("--nfuncs", "n",		"Number of generated functions");
 	help_spaced("--func-maxcalls", "n",	"Set limit for number of functions calls inside function");
 	help_spaced("--cfg-size", "n",		"Set number of generated blocks in control flow graph");
@@ -0,0 +1,114 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "irout.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parameters.h"
+#include "../adt/strutil.h"
+
+#define STRID_PLACEHOLDER "{strid}"
+
+bool check_ir_out(void)
+{
+	const char *dest = fs_params.run.ir_out;
+	if (dest == NULL) {
+		return true;
+	}
+
+	bool several_progs = fs_params.run.count > 1 || fs_params.run.corpus_in != NULL;
+	bool is_stdout     = streq(dest, "-");
+	bool is_stream     = is_stdout || strstart(dest, "fd:") != NULL;
+	if (is_stream && several_progs) {
+		fprintf(stderr, "--ir-out %s can only take a single program, use a path with " STRID_PLACEHOLDER "\n", dest);
+		return false;
+	} else if (!is_stream && several_progs && strstr(dest, STRID_PLACEHOLDER) == NULL) {
+		fprintf(stderr, "--ir-out %s would be overwritten by every program, add " STRID_PLACEHOLDER " to the path\n", dest);
+		return false;
+	}
+
+	if (is_stdout) {
+		const char *other = NULL;
+		if (fs_params.run.server) {
+			other = "--server";
+		} else if (fs_params.run.fan_out != NULL) {
+			other = "--fan-out";
+		} else if (fs_params.run.pass_stats != NULL && streq(fs_params.run.pass_stats, "-")) {
+			other = "--pass-stats -";
+		} else if (fs_params.run.verify_determinism) {
+			other = "--verify-determinism";
+		} else if (fs_params.run.sweep > 0) {
+			other = "--sweep";
+		}
+		if (other != NULL) {
+			fprintf(stderr, "--ir-out - would mix the IR with the output of %s, use fd:N or a path\n", other);
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Copies the path, replacing every {strid} with the strid.
+ */
+static void expand_path(char *file_name, size_t size, const char *path, const char *strid)
+{
+	size_t      len  = 0;
+	const char *next;
+	file_name[0] = '\0';
+	while ((next = strstr(path, STRID_PLACEHOLDER)) != NULL && len < size) {
+		len += snprintf(file_name + len, size - len, "%.*s%s", (int)(next - path), path, strid);
+		path = next + strlen(STRID_PLACEHOLDER);
+	}
+	if (len < size) {
+		snprintf(file_name + len, size - len, "%s", path);
+	}
+}
+
+FILE *open_ir_out(const char *strid, char *file_name, size_t size)
+{
+	const char *dest = fs_params.run.ir_out;
+	file_name[0] = '\0';
+
+	if (dest != NULL && streq(dest, "-")) {
+		return stdout;
+	} else if (dest != NULL && strstart(dest, "fd:")) {
+		// A stream takes a single program (see check_ir_out()), so the
+		// descriptor is simply closed with the export
+		char *end;
+		long  fd = strtol(dest + 3, &end, 10);
+		if (end == dest + 3 || *end != '\0' || fd < 0 || fd > INT_MAX) {
+			fprintf(stderr, "--ir-out %s doesn't name a descriptor\n", dest);
+			return NULL;
+		}
+		FILE *out = fdopen((int)fd, "w");
+		if (out == NULL) {
+			fprintf(stderr, "couldn't open %s for writing: %s\n", dest, strerror(errno));
+		}
+		return out;
+	}
+
+	if (dest != NULL) {
+		expand_path(file_name, size, dest, strid);
+	} else {
+		snprintf(file_name, size, "%s.ir", strid);
+	}
+	FILE *out = fopen(file_name, "w");
+	if (out == NULL) {
+		fprintf(stderr, "couldn't open %s for writing: %s\n", file_name, strerror(errno));
+		file_name[0] = '\0';
+	}
+	return out;
+}
+
+void close_ir_out(FILE *out)
+{
+	if (out == stdout) {
+		fflush(out);
+	} else {
+		fclose(out);
+	}
+}
@@ -0,0 +1,36 @@
+#ifndef IROUT_H
+#define IROUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Checks --ir-out against the other options. Streams carry a single
+ * unframed export, so they are refused if several programs are written
+ * and stdout is refused if anything else prints to it. A path has to
+ * contain {strid} if several programs are written.
+ * @return false after printing the reason, if the combination is invalid
+ */
+bool check_ir_out(void);
+
+/**
+ * Opens the destination of the exported IR selected by --ir-out:
+ * "-" for stdout, "fd:N" for a descriptor inherited from the driver,
+ * any other value as path with {strid} replaced by the program's strid,
+ * and <strid>.ir if the option was not given.
+ *
+ * @param file_name Receives the path if the IR goes to a file that can be
+ *                  read back, the empty string otherwise
+ * @return NULL if the destination could not be opened
+ */
+FILE *open_ir_out(const char *strid, char *file_name, size_t size);
+
+/**
+ * Closes a destination returned by open_ir_out(). Streams are only
+ * flushed, so that the programs of a batch can be written one after the
+ * other.
+ */
+void close_ir_out(FILE *out);
+
+#endif
@@ -117,16 +117,68 @@ bool options_parse(options_state_t *s)
 			fs_params.cfg.has_loops = truth_value;;	
 		} else if (f_yesno_arg("-fmemory", s)) {
 			fs_params.cfb.has_memory_ops = truth_value;
+		} else if (f_yesno_arg("-fcompact", s)) {
+			fs_params.run.compact = truth_value;
 		} else {
 			return NULL;
 		}
 		return true;
 	}
 
+	if (simple_arg("-server", s)) {
+		fs_params.run.server = true;
+		return true;
+	} else if (simple_arg("-verify-determinism", s)) {
+		fs_params.run.verify_determinism = true;
+		return true;
+	}
+
 	const char *arg;
 
+	if (accept_prefix(s, "--passes=", true, &arg)) {
+		fs_params.run.passes = arg;
+		return true;
+	} else if (accept_prefix(s, "--dump=", true, &arg)) {
+		if (streq(arg, "none")) {
+			fs_params.run.dump = DUMP_NONE;
+		} else if (streq(arg, "vcg")) {
+			fs_params.run.dump = DUMP_VCG;
+		} else if (streq(arg, "on-failure")) {
+			fs_params.run.dump = DUMP_ON_FAILURE;
+		} else {
+			fprintf(stderr, "unknown dump mode '%s'\n", arg);
+			s->argument_errors = true;
+		}
+		return true;
+	}
+
 	if ((arg = spaced_arg("seed", s)) != NULL) {
 		fs_params.prog.seed = atoi(arg);
+	} else if ((arg = spaced_arg("count", s)) != NULL) {
+		fs_params.run.count = atoi(arg);
+	} else if ((arg = spaced_arg("jobs", s)) != NULL) {
+		fs_params.run.jobs = atoi(arg);
+	} else if ((arg = spaced_arg("timeout", s)) != NULL) {
+		fs_params.run.timeout = atoi(arg);
+	} else if ((arg = spaced_arg("fan-out", s)) != NULL) {
+		fs_params.run.fan_out = arg;
+	} else if ((arg = spaced_arg("pass-stats", s)) != NULL) {
+		fs_params.run.pass_stats = arg;
+	} else if ((arg = spaced_arg("sweep", s)) != NULL) {
+		fs_params.run.sweep = atoi(arg);
+	} else if ((arg = spaced_arg("sweep-bound", s)) != NULL) {
+		fs_params.run.sweep_bound = atof(arg);
+	} else if ((arg = spaced_arg("sweep-threshold", s)) != NULL) {
+		fs_params.run.sweep_threshold = atof(arg);
+	} else if ((arg = spaced_arg("corpus-out", s)) != NULL) {
+		fs_params.run.corpus_out = arg;
+	} else if ((arg = spaced_arg("corpus-in", s)) != NULL) {
+		fs_params.run.corpus_in = arg;
+	} else if ((arg = spaced_arg("ir-out", s)) != NULL) {
+		fs_params.run.ir_out = arg;
+	} else if ((arg = spaced_arg("dump-from-ir", s)) != NULL) {
+		fs_params.run.dump_from_ir = arg;
+		s->action = action_dump_from_ir;
 	} else if ((arg = spaced_arg("strid", s)) != NULL) {
 		fs_params.prog.strid = arg;
 	} else if ((arg = spaced_arg("nfuncs", s)) != NULL) {
@@ -1,6 +1,25 @@
 #include "parameters.h"
 
 parameters_t fs_params = {
+    .run = {
+        .count = 1,
+        .jobs = 1,
+        .server = false,
+        .timeout = 0,
+        .passes = NULL,
+        .fan_out = NULL,
+        .pass_stats = NULL,
+        .sweep = 0,
+        .sweep_bound = 1.5,
+        .sweep_threshold = 1e-6,
+        .verify_determinism = false,
+        .compact = false,
+        .dump = DUMP_VCG,
+        .dump_from_ir = NULL,
+        .ir_out = NULL,
+        .corpus_out = NULL,
+        .corpus_in = NULL
+    },
     .prog = {
         .seed = 0,
         .strid = "main",
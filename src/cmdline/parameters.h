@@ -2,6 +2,7 @@
 #define PARAMETERS_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct prog_parameters_t {
     int seed;
@@ -26,7 +27,34 @@ typedef struct cfb_parameters_t {
     bool has_func_calls;
 } cfb_parameters_t;
 
+typedef enum dump_mode_t {
+    DUMP_NONE,          /**< no VCG files */
+    DUMP_VCG,           /**< VCG files for every program */
+    DUMP_ON_FAILURE     /**< VCG files rebuilt from the .ir if the run fails */
+} dump_mode_t;
+
+typedef struct run_parameters_t {
+    int count;
+    int jobs;
+    bool server;
+    int timeout;
+    const char *passes;
+    const char *fan_out;
+    const char *pass_stats;
+    int sweep;
+    double sweep_bound;
+    double sweep_threshold;
+    bool verify_determinism;
+    bool compact;
+    dump_mode_t dump;
+    const char *dump_from_ir;
+    const char *ir_out;
+    const char *corpus_out;
+    const char *corpus_in;
+} run_parameters_t;
+
 typedef struct parameters_t {
+    run_parameters_t run;
     prog_parameters_t prog;
     func_parameters_t func;
     cfg_parameters_t cfg;
@@ -0,0 +1,108 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "server.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "help.h"
+
+#define MAX_REQUEST_ARGS 64
+
+/**
+ * Splits the request line in place into an argument vector.
+ * @return Number of arguments including argv0, -1 if there are too many
+ */
+static int split_request(char *line, const char *argv0, char **argv)
+{
+	int argc = 0;
+	argv[argc++] = (char*)argv0;
+	for (char *tok = strtok(line, " \t\r\n"); tok != NULL;
+	     tok = strtok(NULL, " \t\r\n")) {
+		if (argc >= MAX_REQUEST_ARGS)
+			return -1;
+		argv[argc++] = tok;
+	}
+	argv[argc] = NULL;
+	return argc;
+}
+
+/**
+ * Runs inside the forked child: parses the request and runs the action.
+ */
+static void serve_child(const char *argv0, action_func action, char *line)
+{
+	// Keep stdout free for the server replies
+	dup2(STDERR_FILENO, STDOUT_FILENO);
+
+	char *argv[MAX_REQUEST_ARGS + 1];
+	int   argc = split_request(line, argv0, argv);
+	if (argc < 0) {
+		fprintf(stderr, "too many arguments in request\n");
+		_exit(EXIT_FAILURE);
+	}
+
+	options_state_t state;
+	memset(&state, 0, sizeof(state));
+	state.argc   = argc;
+	state.argv   = argv;
+	state.action = action;
+	for (state.i = 1; state.i < state.argc; ++state.i) {
+		if (!options_parse(&state)) {
+			fprintf(stderr, "unknown argument '%s'\n", argv[state.i]);
+			state.argument_errors = true;
+		}
+	}
+	if (state.argument_errors || fs_params.run.server) {
+		help_usage(argv0);
+		_exit(EXIT_FAILURE);
+	}
+
+	if (fs_params.run.timeout > 0)
+		alarm(fs_params.run.timeout);
+	int ret = state.action(argv0);
+	fflush(NULL);
+	_exit(ret);
+}
+
+int serve_requests(const char *argv0, action_func action)
+{
+	char   *line     = NULL;
+	size_t  line_cap = 0;
+
+	// Requests must not inherit the server mode
+	fs_params.run.server = false;
+
+	while (getline(&line, &line_cap, stdin) > 0) {
+		fflush(NULL);
+		pid_t pid = fork();
+		if (pid < 0) {
+			perror("fork");
+			free(line);
+			return EXIT_FAILURE;
+		} else if (pid == 0) {
+			serve_child(argv0, action, line);
+		}
+
+		int status;
+		if (waitpid(pid, &status, 0) < 0) {
+			perror("waitpid");
+			free(line);
+			return EXIT_FAILURE;
+		}
+		if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS) {
+			printf("ok\n");
+		} else if (WIFEXITED(status)) {
+			printf("exit %d\n", WEXITSTATUS(status));
+		} else {
+			printf("signal %d\n", WTERMSIG(status));
+		}
+		fflush(stdout);
+	}
+	free(line);
+	return EXIT_SUCCESS;
+}
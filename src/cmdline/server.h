@@ -0,0 +1,17 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "options.h"
+
+/**
+ * Runs firmsmith as fork server.
+ *
+ * Every line read from stdin holds the options for one program. For each
+ * line a child is forked from the already initialized process, parses the
+ * options into its own copy of the parameters and runs the given action.
+ * The outcome is answered with one line on stdout: "ok", "exit <code>"
+ * or "signal <number>". Output of the children is redirected to stderr.
+ */
+int serve_requests(const char *argv0, action_func action);
+
+#endif
@@ -0,0 +1,162 @@
+#include "sweep.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <libfirm/adt/array.h>
+
+#include "fanout.h"
+#include "parameters.h"
+#include "../lib/optimizations.h"
+
+/**
+ * Sums for the least squares fit of log(time) = exponent * log(nodes) + c
+ */
+typedef struct growth_fit_t {
+	size_t n_samples;
+	double sum_x;
+	double sum_y;
+	double sum_xx;
+	double sum_xy;
+} growth_fit_t;
+
+static void add_sample(growth_fit_t *fit, size_t nodes, double time)
+{
+	// log(0) is undefined, such samples are below the clock resolution anyway
+	if (nodes == 0 || time <= 0.0)
+		return;
+	double x = log((double)nodes);
+	double y = log(time);
+	fit->n_samples += 1;
+	fit->sum_x     += x;
+	fit->sum_y     += y;
+	fit->sum_xx    += x * x;
+	fit->sum_xy    += x * y;
+}
+
+/**
+ * @return the fitted exponent or NAN if the samples don't determine it
+ */
+static double get_exponent(const growth_fit_t *fit)
+{
+	double n     = (double)fit->n_samples;
+	double denom = n * fit->sum_xx - fit->sum_x * fit->sum_x;
+	if (fit->n_samples < 2 || denom <= 0.0)
+		return NAN;
+	return (n * fit->sum_xy - fit->sum_x * fit->sum_y) / denom;
+}
+
+/**
+ * Prints the parameters reproducing the current program.
+ */
+static void print_sample_head(size_t opt)
+{
+	printf("{\"seed\": %d, \"cfg_size\": %d, \"cfb_size\": %d, \"pass\": \"%s\", ",
+	       fs_params.prog.seed, fs_params.cfg.n_blocks, fs_params.cfb.n_nodes,
+	       get_opt_name(opt));
+}
+
+/**
+ * Measures every pass on the program of the current parameters.
+ * @return true if no sample was flagged
+ */
+static bool sweep_prog(const size_t *list, growth_fit_t *fits,
+                       build_prog_func build, finish_prog_func finish,
+                       FILE *stats_out)
+{
+	bool    ok   = true;
+	prog_t *prog = build();
+	for (size_t i = 0; i < ARR_LEN(list); ++i) {
+		size_t      opt = list[i];
+		opt_stats_t stats;
+		if (!fan_out_measure(opt, &stats)) {
+			print_sample_head(opt);
+			printf("\"failed\": true}\n");
+			ok = false;
+			continue;
+		}
+		if (stats_out != NULL)
+			print_opt_stats(stats_out, opt, &stats);
+		add_sample(&fits[opt], stats.nodes_before, stats.cpu_time);
+
+		size_t nodes      = stats.nodes_before > 0 ? stats.nodes_before : 1;
+		double normalized = stats.cpu_time / pow((double)nodes, fs_params.run.sweep_bound);
+		if (normalized > fs_params.run.sweep_threshold) {
+			print_sample_head(opt);
+			printf("\"nodes\": %zu, \"cpu_time\": %.9f, \"normalized\": %g}\n",
+			       stats.nodes_before, stats.cpu_time, normalized);
+			ok = false;
+		}
+	}
+	fflush(stdout);
+	finish(prog);
+	return ok;
+}
+
+/**
+ * Whether the size can be doubled for the given number of steps,
+ * the last step using size << (n_steps - 1).
+ */
+static bool doublings_fit(int size, int n_steps)
+{
+	int shift = n_steps - 1;
+	return size >= 0 && shift < (int)(sizeof(int) * CHAR_BIT) - 1 && size <= (INT_MAX >> shift);
+}
+
+bool check_sweep(void)
+{
+	int n_steps = fs_params.run.sweep;
+	if (n_steps < 0) {
+		fprintf(stderr, "--sweep expects a non-negative number\n");
+		return false;
+	} else if (n_steps > 0 && (!doublings_fit(fs_params.cfg.n_blocks, n_steps)
+	                           || !doublings_fit(fs_params.cfb.n_nodes, n_steps))) {
+		fprintf(stderr, "--sweep %d would double cfg-size %d or cfb-size %d beyond %d\n",
+			n_steps, fs_params.cfg.n_blocks, fs_params.cfb.n_nodes, INT_MAX);
+		return false;
+	}
+	return true;
+}
+
+int sweep_opts(build_prog_func build, finish_prog_func finish, FILE *stats_out)
+{
+	size_t *list = parse_opt_list(fs_params.run.fan_out != NULL ? fs_params.run.fan_out : "all");
+	if (list == NULL)
+		return EXIT_FAILURE;
+
+	growth_fit_t *fits = calloc(get_n_opts(), sizeof(*fits));
+	int  seed     = fs_params.prog.seed;
+	int  n_blocks = fs_params.cfg.n_blocks;
+	int  n_nodes  = fs_params.cfb.n_nodes;
+	bool ok       = true;
+	for (int step = 0; step < fs_params.run.sweep; ++step) {
+		fs_params.cfg.n_blocks = n_blocks << step;
+		fs_params.cfb.n_nodes  = n_nodes << step;
+		for (int i = 0; i < fs_params.run.count; ++i) {
+			fs_params.prog.seed = seed + i;
+			ok &= sweep_prog(list, fits, build, finish, stats_out);
+		}
+	}
+	fs_params.prog.seed    = seed;
+	fs_params.cfg.n_blocks = n_blocks;
+	fs_params.cfb.n_nodes  = n_nodes;
+
+	for (size_t i = 0; i < ARR_LEN(list); ++i) {
+		size_t opt      = list[i];
+		double exponent = get_exponent(&fits[opt]);
+		printf("{\"pass\": \"%s\", \"samples\": %zu, \"exponent\": ",
+		       get_opt_name(opt), fits[opt].n_samples);
+		if (isnan(exponent)) {
+			printf("null}\n");
+		} else {
+			printf("%.3f}\n", exponent);
+		}
+	}
+	fflush(stdout);
+
+	free(fits);
+	DEL_ARR_F(list);
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,35 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../lib/prog.h"
+
+typedef prog_t *(*build_prog_func)(void);
+typedef void (*finish_prog_func)(prog_t *prog);
+
+/**
+ * Looks for passes whose compile time grows super-linearly in graph size.
+ *
+ * Starting from the given cfg-size and cfb-size, both are doubled for
+ * --sweep steps. At every step each program of the --count seed family is
+ * built and every pass of --fan-out (default all) is timed in a forked
+ * child. Samples with cpu_time / nodes^bound above the threshold, and passes
+ * which crashed or produced invalid graphs, are printed as JSON lines
+ * carrying the seed and parameters to reproduce them. Finally a growth
+ * exponent fitted over all samples is printed per pass.
+ * If stats_out is given, every measurement is written to it as well.
+ *
+ * @return EXIT_SUCCESS if no sample was flagged
+ */
+int sweep_opts(build_prog_func build, finish_prog_func finish, FILE *stats_out);
+
+/**
+ * Checks that --sweep is not negative and that doubling cfg-size and
+ * cfb-size for every step stays within int.
+ * @return false after printing the reason, if it does not
+ */
+bool check_sweep(void);
+
+#endif
@@ -3,34 +3,41 @@
 #include <stdlib.h>
 #include <time.h>
 #include <assert.h>
+#include <stdbool.h>
+
+#include "../adt/pdeq.h"
 
 // Functions
 
-static cfb_lmem_t *new_cfb_lmem(cfb_t *cfb) {
+static cfb_lmem_t *new_cfb_lmem(struct obstack *obst, cfb_t *cfb) {
     assert(cfb != NULL);
-    cfb_lmem_t *lmem = malloc(sizeof(cfb_lmem_t));
+    cfb_lmem_t *lmem = OALLOC(obst, cfb_lmem_t);
     INIT_LIST_HEAD(&lmem->head);
     lmem->cfb = cfb;
     return lmem;
 }
 
-temp_t *new_temporary(ir_node *node, ir_type *type) {
-    temp_t *temp = malloc(sizeof(temp_t));
+temp_t *new_temporary(struct obstack *obst, ir_node *node, ir_type *type) {
+    temp_t *temp = OALLOC(obst, temp_t);
     INIT_LIST_HEAD(&temp->head);
+    INIT_LIST_HEAD(&temp->queue);
     temp->node = node;
     temp->type = type;
     temp->resolved = 0;
+    temp->resolver = -1;
     return temp;
 }
 
-void cfb_add_temporary(cfb_t *cfb, ir_node *node, ir_type *type) {
+temp_t *cfb_add_temporary(cfb_t *cfb, ir_node *node, ir_type *type) {
     assert(!is_Primitive_type(type) || get_irn_mode(node) == get_type_mode(type));
     assert(is_Primitive_type(type) || get_irn_mode(node) == mode_P);
     ;//printf("adding %s (%ld) to irb %ld (%d temps)\n",  get_irn_opname(node), get_irn_node_nr(node), get_irn_node_nr(cfb->irb), cfb->n_temporaries);
-    temp_t *temp = new_temporary(node, type);
+    temp_t *temp = new_temporary(cfb->obst, node, type);
     list_add_tail(&temp->head, &cfb->temporaries);
+    list_add_tail(&temp->queue, &cfb->unresolved);
     cfb->n_temporaries += 1;
     cfb->n_nodes += 1;
+    return temp;
 }
 
 static void cfb_list_del(struct list_head* head) {
@@ -67,31 +74,57 @@ void healthy_predecessors(cfb_t *cfb) {
     }
 }
 
-cfb_t *new_cfb() {
-    cfb_t *new_block = malloc(sizeof(cfb_t));
-    assert(new_block != 0);
-    memset(new_block, 0, sizeof(cfb_t));
+/**
+ * Allocates a new block on the obstack of its CFG. The block, its edges and
+ * temporaries are released together with the CFG.
+ */
+cfb_t *new_cfb(struct obstack *obst) {
+    cfb_t *new_block = OALLOCZ(obst, cfb_t);
+    new_block->obst = obst;
     new_block->index = -1;
     new_block->n_successors = 0;
     new_block->n_predecessors = 0;
     new_block->n_temporaries = 0;
+    new_block->queued = 0;
     new_block->visited = 0;
+    for (int i = 0; i < N_CFB_TRANSFORMS; ++i) {
+        new_block->eligible[i] = -1;
+    }
     INIT_LIST_HEAD(&new_block->predecessors);
     INIT_LIST_HEAD(&new_block->successors);
     INIT_LIST_HEAD(&new_block->temporaries);
+    INIT_LIST_HEAD(&new_block->unresolved);
     return new_block;
 }
 
 static void cfb_add_pred(cfb_t *cfb, cfb_t *pred) {
-    cfb_lmem_t *pred_lmem = new_cfb_lmem(pred);
+    cfb_lmem_t *pred_lmem = new_cfb_lmem(cfb->obst, pred);
     list_add_tail(&pred_lmem->head, &cfb->predecessors);
     cfb->n_predecessors++;
 }
 
+/**
+ * Appends only the successor half of an edge. Used to restore a CF graph,
+ * whose predecessor lists are restored separately in their original order.
+ */
+void cfb_append_succ(cfb_t *cfb, cfb_t *succ) {
+    assert(cfb->n_successors + 1 <= MAX_SUCCESSORS);
+    cfb->n_successors++;
+    cfb_lmem_t *succ_lmem = new_cfb_lmem(cfb->obst, succ);
+    list_add_tail(&succ_lmem->head, &cfb->successors);
+}
+
+/**
+ * Appends only the predecessor half of an edge, see cfb_append_succ().
+ */
+void cfb_append_pred(cfb_t *cfb, cfb_t *pred) {
+    cfb_add_pred(cfb, pred);
+}
+
 void cfb_add_succ(cfb_t *cfb, cfb_t *succ) {
     assert(cfb->n_successors + 1 <= MAX_SUCCESSORS);
     cfb->n_successors++;
-    cfb_lmem_t *succ_lmem = new_cfb_lmem(succ);
+    cfb_lmem_t *succ_lmem = new_cfb_lmem(cfb->obst, succ);
     list_add_tail(&succ_lmem->head, &cfb->successors);
     cfb_add_pred(succ, cfb);
 }
@@ -105,7 +138,7 @@ void cfb_transform_T1(cfb_t *cfb) {
 
 cfb_t *cfb_transform_T2a(cfb_t *cfb) {
     assert(cfb->n_successors <= 2);
-    cfb_t *new_block = new_cfb();
+    cfb_t *new_block = new_cfb(cfb->obst);
     int i = 0;
     cfb_for_each_successor(cfb, lmem) {
         ;//printf("%d\t%p\t%d\n", i, lmem->cfb, lmem->cfb->index);
@@ -123,7 +156,7 @@ cfb_t *cfb_transform_T2a(cfb_t *cfb) {
 
 cfb_t *cfb_transform_T2b(cfb_t *cfb) {
     assert(cfb->n_successors > 0 && cfb->n_successors <= 2);
-    cfb_t *new_block = new_cfb();
+    cfb_t *new_block = new_cfb(cfb->obst);
     if (cfb->n_successors == 1) {
         cfb_lmem_t *lmem_first = cfb_lmem_first_successor(cfb);
         cfb_t *succ = lmem_first->cfb;
@@ -143,112 +176,116 @@ cfb_t *cfb_transform_T2b(cfb_t *cfb) {
 }
 
 cfb_t *cfb_transform_T2c(cfb_t *cfb) {
-    cfb_t *new_block = new_cfb();
+    cfb_t *new_block = new_cfb(cfb->obst);
     cfb_add_succ(cfb, new_block);
     return new_block;
 }
 
 // Visit counter
 
-static int __visit_counter = 0;
-
-int get_visit_counter(void) {
-    return __visit_counter;
+int get_visit_counter(const gen_context_t *ctx) {
+    return ctx->visit_counter;
 }
 
-void inc_visit_counter(void) {
-    __visit_counter++;
+void inc_visit_counter(gen_context_t *ctx) {
+    ctx->visit_counter++;
 }
 
 // Print cfb tree
 
-static int print_indent = 0;
-
-static void cfb_print_pre(cfb_t *block) {
-    for (int i = 0; i < print_indent; ++i) {
+static void cfb_print_pre(cfb_t *block, void *env) {
+    int *print_indent = env;
+    for (int i = 0; i < *print_indent; ++i) {
         printf(" ");
     }
     printf("%d [%d P; %d S]\n", block->index, block->n_predecessors, block->n_successors);
-    print_indent += 1;
+    *print_indent += 1;
 }
 
-static void cfb_print_visited(cfb_t *block) {
-    for (int i = 0; i < print_indent; ++i) {
+static void cfb_print_visited(cfb_t *block, void *env) {
+    int *print_indent = env;
+    for (int i = 0; i < *print_indent; ++i) {
         printf("._");
     }
     printf("%d [%d P; %d S] [loop]\n", block->index, block->n_predecessors, block->n_successors);
 }
 
-static void cfb_print_post(cfb_t *block) {
+static void cfb_print_post(cfb_t *block, void *env) {
     (void)block;
-    print_indent -= 1;
+    int *print_indent = env;
+    *print_indent -= 1;
 }
 
-void cfb_print(cfb_t *cfb) {
-    cfb_walk_successors(cfb, cfb_print_pre, cfb_print_post, cfb_print_visited);
+void cfb_print(gen_context_t *ctx, cfb_t *cfb) {
+    int print_indent = 0;
+    cfb_walk_successors(ctx, cfb, cfb_print_pre, cfb_print_post, cfb_print_visited, &print_indent);
     printf("\n");
 }
 
-// Walk predecessor
-
-static void _cfb_walk_predecessors(cfb_t *node, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited) {
-    if (node->visited >= get_visit_counter()) {
-        if (visited) {
-            visited(node);
+// Walks
+
+/**
+  * Depth-first walk over the CF graph using an explicit stack, so that
+  * huge CF graphs do not overflow the call stack.
+  * Each stack frame consists of the block and the list element of the
+  * edge last descended over, the next edge is only looked up once the
+  * walk returns to the block, just as with list_for_each_entry.
+  * The successor walk calls pre before marking the block as visited,
+  * the predecessor walk afterwards.
+  **/
+static void cfb_walk(int visit_counter, cfb_t *node, bool successors, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited, void *env) {
+    pdeq *stack = new_pdeq();
+
+    while (node != NULL) {
+        if (node->visited >= visit_counter) {
+            if (visited) {
+                visited(node, env);
+            }
+        } else {
+            if (!successors) {
+                node->visited = visit_counter;
+            }
+
+            // Pre iteration hook
+            if (pre) {
+                pre(node, env);
+            }
+
+            node->visited = visit_counter;
+
+            struct list_head *edges = successors ? &node->successors : &node->predecessors;
+            pdeq_putr(stack, node);
+            pdeq_putr(stack, edges);
         }
-    } else {
-        node->visited = get_visit_counter();
 
-        // Pre iteration hook
-        if (pre) {
-            pre(node);
-        }
-
-        cfb_for_each_predecessor(node, iterator) {
-            cfb_t *predecessor = cfb_get_predecessor(node, iterator);
-            _cfb_walk_predecessors(predecessor, pre, post, visited);
-        }
-
-        // Post iteration hook
-        if (post) {
-            post(node);
+        // Continue with the next edge of the innermost unfinished block
+        node = NULL;
+        while (node == NULL && !pdeq_empty(stack)) {
+            struct list_head *pos = pdeq_getr(stack);
+            cfb_t *top = pdeq_getr(stack);
+            struct list_head *edges = successors ? &top->successors : &top->predecessors;
+
+            if (pos->next != edges) {
+                pos = pos->next;
+                pdeq_putr(stack, top);
+                pdeq_putr(stack, pos);
+                node = list_entry(pos, cfb_lmem_t, head)->cfb;
+            } else if (post) {
+                // Post iteration hook
+                post(top, env);
+            }
         }
     }
-}
 
-void cfb_walk_predecessors(cfb_t *node, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited) {
-    inc_visit_counter();
-    _cfb_walk_predecessors(node, pre, post, visited);
+    del_pdeq(stack);
 }
 
-// Walk successor
-
-static void _cfb_walk_successors(cfb_t *node, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited) {
-    if (node->visited >= get_visit_counter()) {
-        if (visited) {
-            visited(node);
-        }
-    } else {
-        // Pre iteration hook
-        if (pre) {
-            pre(node);
-        }
-
-        node->visited = get_visit_counter();
-
-        cfb_for_each_successor(node, iterator) {
-            cfb_t *successor = cfb_get_successor(node, iterator);
-            _cfb_walk_successors(successor, pre, post, visited);
-        }
-
-        // Post iteration hook
-        if (post) {
-            post(node);
-        }
-    }
+void cfb_walk_predecessors(gen_context_t *ctx, cfb_t *node, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited, void *env) {
+    inc_visit_counter(ctx);
+    cfb_walk(get_visit_counter(ctx), node, false, pre, post, visited, env);
 }
 
-void cfb_walk_successors(cfb_t *node, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited) {
-    inc_visit_counter();
-    _cfb_walk_successors(node, pre, post, visited);
+void cfb_walk_successors(gen_context_t *ctx, cfb_t *node, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited, void *env) {
+    inc_visit_counter(ctx);
+    cfb_walk(get_visit_counter(ctx), node, true, pre, post, visited, env);
 }
@@ -5,9 +5,23 @@
 #include <libfirm/firm.h>
 #include <libfirm/firm_types.h>
 
+#include "context.h"
+#include "../adt/obst.h"
+
 #define MAX_PREDECESSORS 10
 #define MAX_SUCCESSORS 2
 
+/**
+ * Transformations expanding the CF graph, see cfb_transform_*.
+ */
+typedef enum cfb_transform_kind_t {
+    CFB_T1,
+    CFB_T2A,
+    CFB_T2B,
+    CFB_T2C,
+    N_CFB_TRANSFORMS
+} cfb_transform_kind_t;
+
 #define cfb_for_each_successor(cfb, iterator) \
     list_for_each_entry(cfb_lmem_t, iterator, (&cfb->successors), head)
 
@@ -51,12 +65,18 @@ typedef struct cfb_t {
     struct list_head predecessors; /**< predecessors */
     struct list_head successors;   /**< successors */
     struct list_head temporaries;
+    struct list_head unresolved;   /**< queue of unresolved temporaries */
+    int queued;                    /**< whether the block is on the resolution worklist */
     int visited;
+    int eligible[N_CFB_TRANSFORMS]; /**< position in the eligible block sets of the CFG, -1 if not contained */
+    struct obstack *obst;          /**< obstack of the CFG holding the block */
 } cfb_t;
 
 typedef struct temp_t {
     struct list_head head;
+    struct list_head queue;        /**< entry in the unresolved queue of the block */
     int resolved;
+    int resolver;                  /**< resolver drawn on creation, -1 if none */
     struct ir_type *type;
     ir_node *node;
 } temp_t;
@@ -66,14 +86,16 @@ typedef struct cfb_lmem_t {
     cfb_t *cfb;
 } cfb_lmem_t;
 
-typedef void (*cfb_walker_func)(cfb_t*);
+typedef void (*cfb_walker_func)(cfb_t*, void *env);
 
-cfb_t *new_cfb(void);
-temp_t *new_temporary(ir_node *temp, ir_type *type);
+cfb_t *new_cfb(struct obstack *obst);
+temp_t *new_temporary(struct obstack *obst, ir_node *temp, ir_type *type);
 
-void cfb_add_temporary(cfb_t *cfb, ir_node *temp, ir_type* type);
+temp_t *cfb_add_temporary(cfb_t *cfb, ir_node *temp, ir_type* type);
 void cfb_add_succ(cfb_t *cfb, cfb_t *succ);
-void cfb_print(cfb_t* block);
+void cfb_append_succ(cfb_t *cfb, cfb_t *succ);
+void cfb_append_pred(cfb_t *cfb, cfb_t *pred);
+void cfb_print(gen_context_t *ctx, cfb_t* block);
 
 void cfb_transform_T1(cfb_t *block);
 cfb_t *cfb_transform_T2a(cfb_t *cfb);
@@ -81,10 +103,10 @@ cfb_t *cfb_transform_T2b(cfb_t *cfb);
 cfb_t *cfb_transform_T2c(cfb_t *cfb);
 
 void healthy_predecessors(cfb_t *cfb);
-void cfb_walk_predecessors(cfb_t *node, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited);
-void cfb_walk_successors(cfb_t *node, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited);
+void cfb_walk_predecessors(gen_context_t *ctx, cfb_t *node, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited, void *env);
+void cfb_walk_successors(gen_context_t *ctx, cfb_t *node, cfb_walker_func pre, cfb_walker_func post, cfb_walker_func visited, void *env);
 
-int get_visit_counter(void);
-void inc_visit_counter(void);
+int get_visit_counter(const gen_context_t *ctx);
+void inc_visit_counter(gen_context_t *ctx);
 
 #endif
@@ -1,113 +1,177 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <stdbool.h>
 #include <time.h>
 
+#include <libfirm/adt/array.h>
 #include "cfg.h"
 #include "cfb.h"
+#include "random.h"
 
 
 void cfg_register_bb(cfg_t *cfg, int index, cfb_t* block) {
+    if (index >= cfg->max_blocks) {
+        // Double the table, so that growing a CFG block by block
+        // takes amortized constant time
+        int max_blocks = cfg->max_blocks * 2;
+        if (max_blocks <= index) {
+            max_blocks = index + 1;
+        }
+        cfg->blocks = realloc(cfg->blocks, max_blocks * sizeof(cfb_t*));
+        assert(cfg->blocks != NULL);
+        cfg->max_blocks = max_blocks;
+    }
     block->index = index;
     cfg->blocks[index] = block;
 }
 
-cfg_t *new_cfg(void) {
+/**
+ * Checks the preconditions of a transformation on the given block.
+ */
+static bool cfg_is_eligible(const cfg_t *cfg, const cfb_t *cfb, cfb_transform_kind_t kind) {
+    const cfb_t *start_block = cfg->blocks[CF_GRAPH_START];
+    const cfb_t *end_block = cfg->blocks[CF_GRAPH_END];
+
+    switch (kind) {
+    case CFB_T1:
+        return cfb->n_successors == 1 && cfb != start_block
+            && cfb_lmem_first_successor(cfb)->cfb != cfb;
+    case CFB_T2A:
+        return cfb != end_block && cfb->n_successors > 0;
+    case CFB_T2B:
+        return cfb != end_block && cfb->n_successors > 0 && cfb->n_successors <= 2;
+    case CFB_T2C:
+        return cfb != end_block && cfb->n_successors < 2;
+    default:
+        assert(0);
+        return false;
+    }
+}
+
+/**
+ * Adds the block to or removes it from the eligible block sets after
+ * its successor edges changed. Removal swaps in the last block of the
+ * set, so updates take constant time.
+ */
+static void cfg_update_eligible(cfg_t *cfg, cfb_t *cfb) {
+    for (int kind = 0; kind < N_CFB_TRANSFORMS; ++kind) {
+        bool eligible = cfg_is_eligible(cfg, cfb, kind);
+        int pos = cfb->eligible[kind];
+        if (eligible && pos < 0) {
+            cfb->eligible[kind] = ARR_LEN(cfg->eligible[kind]);
+            ARR_APP1(cfb_t*, cfg->eligible[kind], cfb);
+        } else if (!eligible && pos >= 0) {
+            cfb_t **set = cfg->eligible[kind];
+            size_t last = ARR_LEN(set) - 1;
+            set[pos] = set[last];
+            set[pos]->eligible[kind] = pos;
+            ARR_SHRINKLEN(set, last);
+            cfb->eligible[kind] = -1;
+        }
+    }
+}
+
+static cfg_t *alloc_cfg(int max_blocks) {
     cfg_t *cfg = malloc(sizeof(cfg_t));
     assert(cfg != NULL);
     memset(cfg, 0, sizeof(cfg_t));
+    obstack_init(&cfg->obst);
+    cfg->max_blocks = max_blocks;
+    cfg->blocks = malloc(cfg->max_blocks * sizeof(cfb_t*));
+    assert(cfg->blocks != NULL);
+    for (int kind = 0; kind < N_CFB_TRANSFORMS; ++kind) {
+        cfg->eligible[kind] = NEW_ARR_F(cfb_t*, 0);
+    }
+    return cfg;
+}
+
+/**
+ * Creates a CFG of n_blocks blocks without any edges, to be connected
+ * with cfb_append_succ() and cfb_append_pred() when restoring a CFG.
+ * The eligible block sets stay empty, the CFG cannot be expanded.
+ */
+cfg_t *new_unconnected_cfg(int n_blocks) {
+    assert(n_blocks >= 2);
+    cfg_t *cfg = alloc_cfg(n_blocks);
+    for (int i = 0; i < n_blocks; ++i) {
+        cfg_register_bb(cfg, i, new_cfb(&cfg->obst));
+    }
+    cfg->n_blocks = n_blocks;
+    return cfg;
+}
+
+cfg_t *new_cfg(void) {
+    cfg_t *cfg = alloc_cfg(4);
     /* Create new start and end block */
-    cfb_t *start = new_cfb();
-    cfb_t *end = new_cfb();
+    cfb_t *start = new_cfb(&cfg->obst);
+    cfb_t *end = new_cfb(&cfg->obst);
     cfg_register_bb(cfg, CF_GRAPH_START, start);
     cfg_register_bb(cfg, CF_GRAPH_END, end);
     cfg->n_blocks = 2;
     /* Connect start and end block */
     cfb_add_succ(start, end);
+    cfg_update_eligible(cfg, start);
+    cfg_update_eligible(cfg, end);
 
     return cfg;
 }
 
 void destroy_cfg(cfg_t *cfg) {
-    for (int i = 0; i < cfg->n_blocks; ++i) {
-        free(cfg->blocks[i]);
-        cfg->blocks[i] = NULL;
+    obstack_free(&cfg->obst, NULL);
+    for (int kind = 0; kind < N_CFB_TRANSFORMS; ++kind) {
+        DEL_ARR_F(cfg->eligible[kind]);
     }
+    free(cfg->blocks);
+    free(cfg);
 }
 
-static cfb_t* cfg_random_block(cfg_t *cfg) {
-    int r = rand() % cfg->n_blocks;
-    return cfg->blocks[r];
-}
+/**
+ * Applies one random transformation to a random block.
+ * The pair is drawn uniformly from all pairs whose preconditions hold,
+ * using the eligible block sets, so a step takes constant time.
+ */
+void cfg_expand(rng_t *rng, cfg_t *cfg) {
+    size_t n_eligible = 0;
+    for (int kind = 0; kind < N_CFB_TRANSFORMS; ++kind) {
+        n_eligible += ARR_LEN(cfg->eligible[kind]);
+    }
+    // The start block always has a successor, so T2a applies to it
+    assert(n_eligible > 0);
 
-void cfg_expand(cfg_t *cfg) {
-    cfb_t *start_block = cfg_get_start(cfg);
-    cfb_t *end_block = cfg_get_end(cfg);
-    //cfb_t *end_block = NULL;
-    int cont = 1;
-    while (cont) {
-        cfb_t *random_block = cfg_random_block(cfg);
-        /* Choose random tranformation */
-        int trans_nr = rand() % 4;
-        /*
-        cfg_print(cfg);
-        for (int i = 0; i < cfg->n_blocks; ++i) 
-            healthy_predecessors(cfg->blocks[i]);
-        cfg_print(cfg);
-        */
-
-        switch (trans_nr) {
-        /* Transformation: T1 */    
-        case 0: {
-            if (random_block->n_successors == 1 && random_block != start_block) {
-                int has_loop = 0;
-                cfb_for_each_successor(random_block, succ_it) {
-                    cfb_t *succ = cfb_get_successor(random_block, succ_it);
-                    if (succ == random_block)
-                        has_loop = 1;
-                }
-                if (!has_loop) {
-                    ;//printf("T1\n");
-                    
-                    cfb_transform_T1(random_block);
-                    cont = 0;
-                }
-            }
-            break;
-        }
-        /* Transformation: T2a */
-        case 1: {
-            if (random_block != end_block && random_block->n_successors > 0) {
-                cfb_t *new_block = cfb_transform_T2a(random_block);
-                cfg_register_bb(cfg, cfg->n_blocks++, new_block);
-                cont = 0;
-            }
-            break;
-        }
-        /* Transformation: T2b */
-        case 2: {
-            if (random_block != end_block && random_block->n_successors > 0 && random_block->n_successors <= 2) {
-                cfb_t *new_block = cfb_transform_T2b(random_block);
-                cfg_register_bb(cfg, cfg->n_blocks++, new_block);
-                cont = 0;
-            }
-            break;
-        }
-        /* Transformation: T2c */
-        case 3: {
-            if (random_block != end_block && random_block->n_successors < 2) {
-                cfb_t *new_block = cfb_transform_T2c(random_block);
-                cfg_register_bb(cfg, cfg->n_blocks++, new_block);
-                cont = 0;
-            }
-            break;
-        }
-        }
+    size_t r = rng_below(rng, n_eligible);
+    int kind = 0;
+    while (r >= ARR_LEN(cfg->eligible[kind])) {
+        r -= ARR_LEN(cfg->eligible[kind]);
+        kind += 1;
+    }
+    cfb_t *random_block = cfg->eligible[kind][r];
+
+    cfb_t *new_block = NULL;
+    switch (kind) {
+    /* Transformation: T1 */
+    case CFB_T1:
+        cfb_transform_T1(random_block);
+        break;
+    /* Transformation: T2a */
+    case CFB_T2A:
+        new_block = cfb_transform_T2a(random_block);
+        break;
+    /* Transformation: T2b */
+    case CFB_T2B:
+        new_block = cfb_transform_T2b(random_block);
+        break;
+    /* Transformation: T2c */
+    case CFB_T2C:
+        new_block = cfb_transform_T2c(random_block);
+        break;
+    }
 
-        //cfg_print(cfg);
-        /*
-        for (int i = 0; i < cfg->n_blocks; ++i) 
-            healthy_predecessors(cfg->blocks[i]);*/
+    // Only the successor edges of the transformed and the new block changed
+    cfg_update_eligible(cfg, random_block);
+    if (new_block != NULL) {
+        cfg_register_bb(cfg, cfg->n_blocks++, new_block);
+        cfg_update_eligible(cfg, new_block);
     }
 }
 
@@ -119,6 +183,6 @@ cfb_t* cfg_get_end(cfg_t *cfg) {
     return cfg->blocks[CF_GRAPH_END];
 }
 
-void cfg_print(cfg_t *cfg) {
-    cfb_print(cfg_get_start(cfg));
+void cfg_print(gen_context_t *ctx, cfg_t *cfg) {
+    cfb_print(ctx, cfg_get_start(cfg));
 }
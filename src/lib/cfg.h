@@ -3,20 +3,22 @@
 
 #include "cfb.h"
 
-#define MAX_CF_BLOCKS 1000
-
 #define CF_GRAPH_START 0
 #define CF_GRAPH_END 1
 
 typedef struct cfg_t {
+    struct obstack obst;    /**< holds the blocks and their edges and temporaries */
     int n_blocks;
-    cfb_t *blocks[MAX_CF_BLOCKS];
+    int max_blocks;         /**< capacity of the block table */
+    cfb_t **blocks;         /**< blocks by index */
+    cfb_t **eligible[N_CFB_TRANSFORMS]; /**< blocks each transformation applies to */
 } cfg_t;
 
 cfg_t *new_cfg(void);
+cfg_t *new_unconnected_cfg(int n_blocks);
 void destroy_cfg(cfg_t *cfg);
-void cfg_expand(cfg_t *cfg);
-void cfg_print(cfg_t *cfg);
+void cfg_expand(rng_t *rng, cfg_t *cfg);
+void cfg_print(gen_context_t *ctx, cfg_t *cfg);
 
 cfb_t* cfg_get_start(cfg_t *cfg);
 cfb_t* cfg_get_end(cfg_t *cfg);
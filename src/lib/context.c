@@ -0,0 +1,19 @@
+#include <assert.h>
+#include <stdlib.h>
+
+#include "context.h"
+
+/**
+  * Allocates a new generator context with all random streams
+  * seeded from the given seed.
+  **/
+gen_context_t *new_gen_context(uint64_t seed) {
+    gen_context_t *ctx = calloc(1, sizeof(gen_context_t));
+    assert(ctx != NULL);
+    seed_random_streams(ctx->streams, seed);
+    return ctx;
+}
+
+void free_gen_context(gen_context_t *ctx) {
+    free(ctx);
+}
@@ -0,0 +1,42 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <libfirm/firm.h>
+
+#include "random.h"
+
+/**
+  * State of the generation of a single program.
+  *
+  * Every generator component works on the context passed to it instead
+  * of file scope variables, so that several programs (or the abstract
+  * graphs of several functions) can be generated at the same time.
+  * The resolver tables set up by initialize_resolve() are read-only
+  * afterwards and shared by all contexts.
+  **/
+typedef struct gen_context_t {
+    rng_t streams[N_STREAMS];    /**< random streams, see random_stream_t */
+    int visit_counter;           /**< visit counter of the CF block walks */
+    int func_visit_counter;      /**< visit counter of the call graph walks */
+    int func_counter;            /**< number of functions named so far */
+    unsigned opcodes[iro_last];  /**< number of generated nodes per opcode */
+
+    // Resolution context
+    struct prog_t *prog;
+    struct func_t *func;
+    struct cfg_t *cfg;
+    struct cfb_t *cfb;
+    struct temp_t *temp;
+    struct reach_t *reach;       /**< reachability index of the function */
+    struct cpmap_t **resolved;   /**< per CF block: type -> resolved nodes, NULL until the first one */
+    struct pdeq *worklist;       /**< CF blocks with unresolved temporaries */
+} gen_context_t;
+
+gen_context_t *new_gen_context(uint64_t seed);
+void free_gen_context(gen_context_t *ctx);
+
+static inline rng_t *get_ctx_stream(gen_context_t *ctx, random_stream_t stream) {
+    return &ctx->streams[stream];
+}
+
+#endif
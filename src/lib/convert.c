@@ -8,6 +8,8 @@
 #include "cfg.h"
 #include "cfb.h"
 #include "func.h"
+#include "random.h"
+#include "../adt/pdeq.h"
 
 static void add_cfb_pred_jmp(cfb_t *cfb, ir_node* jmp) {
     if (!cfb->irb) {
@@ -17,11 +19,12 @@ static void add_cfb_pred_jmp(cfb_t *cfb, ir_node* jmp) {
     add_immBlock_pred(cfb->irb, jmp);
 }
 
-static void convert_cfb(cfb_t *cfb) {
-    if (cfb->visited >= get_visit_counter()) {
-        return;
-    }
-    cfb->visited = get_visit_counter();
+/**
+  * Constructs the nodes of a CF block which do not depend on its
+  * successors being converted.
+  * Returns the Cond node if the block branches, NULL otherwise.
+  **/
+static ir_node *convert_cfb_enter(cfb_t *cfb) {
     cfb->mem = cfb->last_mem = new_Dummy(mode_M);
 
     assert(cfb->n_successors >= 0 && cfb->n_successors <= 2);
@@ -32,33 +35,9 @@ static void convert_cfb(cfb_t *cfb) {
         ir_node *dummy = new_Dummy(mode_b);
         ir_node *cnd = new_Cond(dummy);
 
-        cfb_add_temporary(cfb, dummy, new_type_primitive(mode_b));
-
-        int succ_count = 0;
-        cfb_for_each_successor(cfb, succ_iterator) {
-            cfb_t *succ = cfb_get_successor(cfb, succ_iterator);
-            add_cfb_pred_jmp(
-                succ,
-                new_Proj(cnd, mode_X, succ_count == 0 ? pn_Cond_false : pn_Cond_true)
-            );
-            /*
-            printf("Add %s projection as predecessor %ld to block %ld\n", succ_count == 0 ? "true" : "false",
-                get_irn_node_nr(cfb->irb), get_irn_node_nr(succ->irb)
-            );
-            */
-            convert_cfb(succ);
-            succ_count += 1;
-        }
-        assert(succ_count == 2);
-
-    } else if (cfb->n_successors == 1) {
-        
-        cfb_for_each_successor(cfb, succ_iterator) {
-            cfb_t *succ = cfb_get_successor(cfb, succ_iterator);
-            add_cfb_pred_jmp(succ, new_Jmp());
-            convert_cfb(succ);
-        }
-    } else {
+        cfb_add_temporary(cfb, dummy, get_bool_type());
+        return cnd;
+    } else if (cfb->n_successors == 0) {
         /* No successors, we have an exit */
         ir_graph *irg   = get_current_ir_graph();
         ir_entity *ent  = get_irg_entity(irg);
@@ -78,16 +57,68 @@ static void convert_cfb(cfb_t *cfb) {
         ir_node *end_block = get_irg_end_block(irg);
         add_immBlock_pred(end_block, res);
     }
+    return NULL;
+}
+
+/**
+  * Converts the CF blocks reachable from cfb depth first.
+  * The control flow edge to a successor is constructed right before
+  * descending into it, the same order a recursive conversion would use.
+  * Frames on the explicit stack hold the block, its Cond node (or NULL)
+  * and the successor list element last descended over.
+  **/
+static void convert_cfb(gen_context_t *ctx, cfb_t *cfb) {
+    pdeq *stack = new_pdeq();
+
+    while (cfb != NULL) {
+        if (cfb->visited < get_visit_counter(ctx)) {
+            cfb->visited = get_visit_counter(ctx);
+            ir_node *cnd = convert_cfb_enter(cfb);
+            pdeq_putr(stack, cfb);
+            pdeq_putr(stack, cnd);
+            pdeq_putr(stack, &cfb->successors);
+        }
+
+        // Construct the next control flow edge and descend over it
+        cfb = NULL;
+        while (cfb == NULL && !pdeq_empty(stack)) {
+            struct list_head *pos = pdeq_getr(stack);
+            ir_node *cnd = pdeq_getr(stack);
+            cfb_t *top = pdeq_getr(stack);
+
+            if (pos->next == &top->successors) {
+                continue;
+            }
+
+            int succ_count = pos == &top->successors ? 0 : 1;
+            pos = pos->next;
+            cfb = list_entry(pos, cfb_lmem_t, head)->cfb;
+            if (cnd != NULL) {
+                add_cfb_pred_jmp(
+                    cfb,
+                    new_Proj(cnd, mode_X, succ_count == 0 ? pn_Cond_false : pn_Cond_true)
+                );
+            } else {
+                add_cfb_pred_jmp(cfb, new_Jmp());
+            }
+
+            pdeq_putr(stack, top);
+            pdeq_putr(stack, cnd);
+            pdeq_putr(stack, pos);
+        }
+    }
 
+    del_pdeq(stack);
 }
 
 
-static void mature_cfb(cfb_t *cfb) {
+static void mature_cfb(cfb_t *cfb, void *env) {
+    (void)env;
     ;//printf("mature cfb with index %d has node nr %ld\n", cfb->index, get_irn_node_nr(cfb->irb));
     mature_immBlock(cfb->irb);
 }
 
-static void convert_cfg(cfg_t *cfg) {
+static void convert_cfg(gen_context_t *ctx, cfg_t *cfg) {
     // Construction
     ir_graph *irg = get_current_ir_graph();
     ir_node *irb = get_r_cur_block(irg);
@@ -95,17 +126,17 @@ static void convert_cfg(cfg_t *cfg) {
     cfb_t *start = cfg_get_start(cfg);
     start->irb = irb;
 
-    inc_visit_counter();
-    convert_cfb(start);
+    inc_visit_counter(ctx);
+    convert_cfb(ctx, start);
 }
 
-void convert_func(func_t *func) {
+void convert_func(gen_context_t *ctx, func_t *func) {
     // Construct Int Type 
     ir_type *int_type = get_int_type();
     // Construct method type
     ir_type *proto = new_type_method(
         func->n_params, func->n_res, false, cc_cdecl_set,
-        (func->name[0] == 'm' || rand() % 2 == 0) ?
+        (func->name[0] == 'm' || rng_below(get_ctx_stream(ctx, STREAM_CFG), 2) == 0) ?
             mtp_no_property :
             mtp_property_inline_recommended
     );
@@ -126,8 +157,8 @@ void convert_func(func_t *func) {
     set_current_ir_graph(irg);
 
     // Convert control flow graph
-    convert_cfg(func->cfg);
-    cfb_walk_successors(cfg_get_start(func->cfg), NULL, mature_cfb, NULL);
+    convert_cfg(ctx, func->cfg);
+    cfb_walk_successors(ctx, cfg_get_start(func->cfg), NULL, mature_cfb, NULL, NULL);
 
     // Reset old irg
     //mature_immBlock(get_r_cur_block(irg));
@@ -135,7 +166,7 @@ void convert_func(func_t *func) {
 
 void convert_prog(prog_t *prog) {
     for (size_t i = 0; i < ARR_LEN(prog->funcs); ++i) {
-        convert_func(prog->funcs[i]);
+        convert_func(prog->ctx, prog->funcs[i]);
     }
 }
 
@@ -6,7 +6,7 @@
 #include "prog.h"
 #include "func.h"
 
-void convert_func(func_t* func);
+void convert_func(gen_context_t *ctx, func_t* func);
 void convert_prog(prog_t* prog);
 void finalize_convert(prog_t *prog);
 #endif
@@ -0,0 +1,381 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libfirm/adt/array.h>
+
+#include "../adt/cpmap.h"
+#include "../adt/hashptr.h"
+#include "../adt/strutil.h"
+#include "../cmdline/parameters.h"
+#include "corpus.h"
+#include "random.h"
+#include "resolve.h"
+#include "types.h"
+
+// The last byte is the version of the record layout
+static const char corpus_magic[4] = { 'F', 'S', 'C', '2' };
+
+// Version of the generator behind the fingerprinted tables. Increment it
+// whenever a change makes a seed produce other programs, e.g. a changed
+// adopt function or a new random draw, so that records of older builds
+// are rejected instead of silently rebuilding other programs.
+#define CORPUS_GENERATOR_VERSION 1
+
+// Flags of the generation parameters
+#define CORPUS_HAS_CYCLES      (1u << 0)
+#define CORPUS_HAS_LOOPS       (1u << 1)
+#define CORPUS_HAS_MEMORY_OPS  (1u << 2)
+#define CORPUS_HAS_FUNC_CALLS  (1u << 3)
+
+// Bounds of the counts of a record, far above anything generated
+#define CORPUS_MAX_FUNCS   (1 << 16)
+#define CORPUS_MAX_BLOCKS  (1 << 20)
+
+// Name of the function added by the driver, see generate_main_func()
+#define CORPUS_RESERVED_NAME "main"
+
+// Writing
+
+static void write_varint(FILE *out, uint64_t value) {
+    while (value >= 0x80) {
+        putc((int)(value & 0x7f) | 0x80, out);
+        value >>= 7;
+    }
+    putc((int)value, out);
+}
+
+static void write_int(FILE *out, int value) {
+    // Zigzag encoding keeps small negative values short
+    uint64_t v = (uint64_t)(int64_t)value;
+    write_varint(out, (v << 1) ^ (value < 0 ? UINT64_MAX : 0));
+}
+
+static void write_u64(FILE *out, uint64_t value) {
+    for (int b = 0; b < 8; ++b) {
+        putc((int)((value >> (8 * b)) & 0xff), out);
+    }
+}
+
+static void write_rng(FILE *out, const rng_t *rng) {
+    for (int i = 0; i < 4; ++i) {
+        write_u64(out, rng->state[i]);
+    }
+}
+
+/**
+  * Writes the successors and predecessors of every block as indices,
+  * in list order, since both orders are visible to the conversion and
+  * the resolution.
+  **/
+static void write_cfg(FILE *out, const cfg_t *cfg) {
+    write_varint(out, cfg->n_blocks);
+    for (int i = 0; i < cfg->n_blocks; ++i) {
+        cfb_t *cfb = cfg->blocks[i];
+        write_varint(out, cfb->n_successors);
+        cfb_for_each_successor(cfb, succ_it) {
+            write_varint(out, cfb_get_successor(cfb, succ_it)->index);
+        }
+        write_varint(out, cfb->n_predecessors);
+        cfb_for_each_predecessor(cfb, pred_it) {
+            write_varint(out, cfb_get_predecessor(cfb, pred_it)->index);
+        }
+    }
+}
+
+bool corpus_write_prog(FILE *out, const prog_t *prog) {
+    const gen_context_t *ctx = prog->ctx;
+    fwrite(corpus_magic, 1, sizeof(corpus_magic), out);
+    write_varint(out, CORPUS_GENERATOR_VERSION);
+    write_u64(out, resolve_fingerprint());
+
+    unsigned flags = 0;
+    flags |= fs_params.prog.has_cycles     ? CORPUS_HAS_CYCLES     : 0;
+    flags |= fs_params.cfg.has_loops       ? CORPUS_HAS_LOOPS      : 0;
+    flags |= fs_params.cfb.has_memory_ops  ? CORPUS_HAS_MEMORY_OPS : 0;
+    flags |= fs_params.cfb.has_func_calls  ? CORPUS_HAS_FUNC_CALLS : 0;
+    write_int(out, fs_params.prog.seed);
+    write_varint(out, flags);
+    write_int(out, fs_params.func.max_calls);
+    write_int(out, fs_params.cfg.n_blocks);
+    write_int(out, fs_params.cfb.n_nodes);
+
+    write_u64(out, types_fingerprint());
+    write_int(out, ctx->func_counter);
+    for (int i = 0; i < N_STREAMS; ++i) {
+        write_rng(out, &ctx->streams[i]);
+    }
+
+    write_varint(out, ARR_LEN(prog->funcs));
+    for (size_t i = 0; i < ARR_LEN(prog->funcs); ++i) {
+        const func_t *func = prog->funcs[i];
+        size_t len = strlen(func->name);
+        write_varint(out, len);
+        fwrite(func->name, 1, len, out);
+        write_varint(out, func->n_params);
+        write_varint(out, func->n_res);
+        write_cfg(out, func->cfg);
+    }
+    return !ferror(out);
+}
+
+// Reading
+
+static bool read_varint(FILE *in, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = getc(in);
+        if (c == EOF) {
+            return false;
+        }
+        result |= (uint64_t)(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool read_int(FILE *in, int *value) {
+    uint64_t v;
+    if (!read_varint(in, &v)) {
+        return false;
+    }
+    *value = (int)(int64_t)((v >> 1) ^ (~(v & 1) + 1));
+    return true;
+}
+
+/**
+  * Reads an unsigned value and checks it against the given bound
+  **/
+static bool read_count(FILE *in, uint64_t bound, int *value) {
+    uint64_t v;
+    if (!read_varint(in, &v) || v > bound) {
+        return false;
+    }
+    *value = (int)v;
+    return true;
+}
+
+static bool read_u64(FILE *in, uint64_t *value) {
+    uint64_t word = 0;
+    for (int b = 0; b < 8; ++b) {
+        int c = getc(in);
+        if (c == EOF) {
+            return false;
+        }
+        word |= (uint64_t)c << (8 * b);
+    }
+    *value = word;
+    return true;
+}
+
+static bool read_rng(FILE *in, rng_t *rng) {
+    for (int i = 0; i < 4; ++i) {
+        if (!read_u64(in, &rng->state[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool read_block_index(FILE *in, const cfg_t *cfg, cfb_t **cfb) {
+    int index;
+    if (!read_count(in, cfg->n_blocks - 1, &index)) {
+        return false;
+    }
+    *cfb = cfg->blocks[index];
+    return true;
+}
+
+static int count_successor(cfb_t *cfb, const cfb_t *succ) {
+    int n = 0;
+    cfb_for_each_successor(cfb, succ_it) {
+        n += cfb_get_successor(cfb, succ_it) == succ;
+    }
+    return n;
+}
+
+static int count_predecessor(cfb_t *cfb, const cfb_t *pred) {
+    int n = 0;
+    cfb_for_each_predecessor(cfb, pred_it) {
+        n += cfb_get_predecessor(cfb, pred_it) == pred;
+    }
+    return n;
+}
+
+/**
+  * Checks that every edge appears as often in the successor list of
+  * its source as in the predecessor list of its target.
+  **/
+static bool edges_consistent(const cfg_t *cfg) {
+    long n_succ_edges = 0;
+    long n_pred_edges = 0;
+    for (int i = 0; i < cfg->n_blocks; ++i) {
+        cfb_t *cfb = cfg->blocks[i];
+        n_succ_edges += cfb->n_successors;
+        n_pred_edges += cfb->n_predecessors;
+        cfb_for_each_predecessor(cfb, pred_it) {
+            cfb_t *pred = cfb_get_predecessor(cfb, pred_it);
+            if (count_predecessor(cfb, pred) != count_successor(pred, cfb)) {
+                return false;
+            }
+        }
+    }
+    // Every predecessor entry is matched, so equal totals leave no
+    // successor entry unmatched
+    return n_succ_edges == n_pred_edges;
+}
+
+static cfg_t *read_cfg(FILE *in) {
+    int n_blocks;
+    if (!read_count(in, CORPUS_MAX_BLOCKS, &n_blocks) || n_blocks < 2) {
+        return NULL;
+    }
+    cfg_t *cfg = new_unconnected_cfg(n_blocks);
+    for (int i = 0; i < n_blocks; ++i) {
+        cfb_t *cfb = cfg->blocks[i];
+        int n_successors;
+        int n_predecessors;
+        if (!read_count(in, MAX_SUCCESSORS, &n_successors)) {
+            goto malformed;
+        }
+        for (int j = 0; j < n_successors; ++j) {
+            cfb_t *succ;
+            if (!read_block_index(in, cfg, &succ)) {
+                goto malformed;
+            }
+            cfb_append_succ(cfb, succ);
+        }
+        if (!read_count(in, (uint64_t)n_blocks * MAX_SUCCESSORS, &n_predecessors)) {
+            goto malformed;
+        }
+        for (int j = 0; j < n_predecessors; ++j) {
+            cfb_t *pred;
+            if (!read_block_index(in, cfg, &pred)) {
+                goto malformed;
+            }
+            cfb_append_pred(cfb, pred);
+        }
+    }
+    if (!edges_consistent(cfg)) {
+        goto malformed;
+    }
+    return cfg;
+
+malformed:
+    destroy_cfg(cfg);
+    return NULL;
+}
+
+corpus_status_t corpus_read_params(FILE *in) {
+    char magic[sizeof(corpus_magic)];
+    size_t n = fread(magic, 1, sizeof(magic), in);
+    if (n == 0 && feof(in)) {
+        return CORPUS_END;
+    }
+    if (n != sizeof(magic) || memcmp(magic, corpus_magic, sizeof(magic) - 1) != 0) {
+        return CORPUS_ERROR;
+    } else if (magic[sizeof(magic) - 1] != corpus_magic[sizeof(magic) - 1]) {
+        return CORPUS_STALE;
+    }
+
+    uint64_t version, resolvers;
+    if (!read_varint(in, &version) || !read_u64(in, &resolvers)) {
+        return CORPUS_ERROR;
+    } else if (version != CORPUS_GENERATOR_VERSION || resolvers != resolve_fingerprint()) {
+        return CORPUS_STALE;
+    }
+
+    int seed, max_calls, n_blocks, n_nodes;
+    uint64_t flags;
+    if (!read_int(in, &seed) || !read_varint(in, &flags)
+        || !read_int(in, &max_calls) || !read_int(in, &n_blocks)
+        || !read_int(in, &n_nodes)
+        || max_calls < 0 || n_blocks < 0 || n_blocks > CORPUS_MAX_BLOCKS || n_nodes < 0) {
+        return CORPUS_ERROR;
+    }
+    fs_params.prog.seed           = seed;
+    fs_params.prog.has_cycles     = (flags & CORPUS_HAS_CYCLES) != 0;
+    fs_params.cfg.has_loops       = (flags & CORPUS_HAS_LOOPS) != 0;
+    fs_params.cfb.has_memory_ops  = (flags & CORPUS_HAS_MEMORY_OPS) != 0;
+    fs_params.cfb.has_func_calls  = (flags & CORPUS_HAS_FUNC_CALLS) != 0;
+    fs_params.func.max_calls      = max_calls;
+    fs_params.cfg.n_blocks        = n_blocks;
+    fs_params.cfb.n_nodes         = n_nodes;
+    return CORPUS_OK;
+}
+
+static unsigned hash_name(const void *name) {
+    return firm_fnv_hash_str(name);
+}
+
+static int names_equal(const void *name1, const void *name2) {
+    return streq(name1, name2);
+}
+
+prog_t *corpus_read_prog(FILE *in, gen_context_t *ctx, corpus_status_t *status) {
+    *status = CORPUS_ERROR;
+    uint64_t types;
+    if (!read_u64(in, &types)) {
+        return NULL;
+    } else if (types != types_fingerprint()) {
+        *status = CORPUS_STALE;
+        return NULL;
+    }
+
+    // The streams continue where the generation left them, so the
+    // resolution draws the same choices
+    if (!read_int(in, &ctx->func_counter)) {
+        return NULL;
+    }
+    for (int i = 0; i < N_STREAMS; ++i) {
+        if (!read_rng(in, &ctx->streams[i])) {
+            return NULL;
+        }
+    }
+
+    int n_funcs;
+    if (!read_count(in, CORPUS_MAX_FUNCS, &n_funcs) || n_funcs < 1) {
+        return NULL;
+    }
+    // The names become entity idents of the global type and must be unique
+    cpmap_t names;
+    cpmap_init(&names, hash_name, names_equal);
+    prog_t *prog = new_prog(ctx);
+    for (int i = 0; i < n_funcs; ++i) {
+        char name[FUNC_NAME_LEN];
+        int  len, n_params, n_res;
+        if (!read_count(in, FUNC_NAME_LEN - 1, &len) || len == 0
+            || fread(name, 1, len, in) != (size_t)len) {
+            goto malformed;
+        }
+        name[len] = '\0';
+        if (memchr(name, '\0', len) != NULL || streq(name, CORPUS_RESERVED_NAME)
+            || cpmap_find(&names, name) != NULL) {
+            goto malformed;
+        }
+        // Only the arity of generated functions can be resolved
+        if (!read_count(in, FUNC_N_PARAMS, &n_params) || n_params != FUNC_N_PARAMS
+            || !read_count(in, FUNC_N_RES, &n_res) || n_res != FUNC_N_RES) {
+            goto malformed;
+        }
+        cfg_t *cfg = read_cfg(in);
+        if (cfg == NULL) {
+            goto malformed;
+        }
+        func_t *func = new_func_with_cfg(name, n_params, n_res, cfg);
+        ARR_APP1(func_t*, prog->funcs, func);
+        cpmap_set(&names, func->name, func);
+    }
+    cpmap_destroy(&names);
+    fs_params.prog.n_funcs = n_funcs;
+    *status = CORPUS_OK;
+    return prog;
+
+malformed:
+    cpmap_destroy(&names);
+    destroy_prog(prog);
+    return NULL;
+}
@@ -0,0 +1,56 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "prog.h"
+
+/**
+  * Binary corpus of generated programs.
+  *
+  * A record holds what is needed to rebuild a program through
+  * convert_prog() and resolve_prog() without generating it again:
+  * the generation parameters, the seed the type universe is built
+  * from, the states of the random streams right after the CFGs were
+  * generated (these decide every later resolver choice) and the shape
+  * of every CFG, including the order of the edge lists.
+  * Integers are stored as LEB128 varints, stream states as little
+  * endian 64 bit words. Records are simply concatenated.
+  *
+  * Since the record replays the random streams instead of storing the
+  * choices, it only rebuilds the same program with the same generator.
+  * Each record therefore carries the generator version and fingerprints
+  * of the resolver tables and of the type universe; records not matching
+  * the running generator are rejected as stale.
+  **/
+
+typedef enum corpus_status_t {
+    CORPUS_OK,
+    CORPUS_END,     /**< no further record */
+    CORPUS_ERROR,   /**< truncated or malformed record */
+    CORPUS_STALE    /**< record of a generator producing other programs */
+} corpus_status_t;
+
+/**
+  * Appends a record of the program, which has to be freshly generated
+  * by new_random_prog(), i.e. not yet converted.
+  **/
+bool corpus_write_prog(FILE *out, const prog_t *prog);
+
+/**
+  * Reads the generation parameters of the next record into fs_params.
+  * The caller then sets up a context and the types for them, as for
+  * generating a program, and calls corpus_read_prog().
+  * @return CORPUS_STALE if the record is of another generator version
+  **/
+corpus_status_t corpus_read_params(FILE *in);
+
+/**
+  * Reads the rest of the record into a new program of the context.
+  * @return NULL with status CORPUS_ERROR or CORPUS_STALE if the record
+  *         is malformed or the types differ from the recorded ones
+  **/
+prog_t *corpus_read_prog(FILE *in, gen_context_t *ctx, corpus_status_t *status);
+
+#endif
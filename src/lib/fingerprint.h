@@ -0,0 +1,36 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+  * 64 bit FNV-1a fingerprints of the tables a program is generated from,
+  * see corpus.h. Values are fed in as 64 bit little endian words.
+  **/
+
+#define FINGERPRINT_INIT UINT64_C(0xcbf29ce484222325)
+
+static inline uint64_t fingerprint_add(uint64_t fp, uint64_t value) {
+    for (int b = 0; b < 8; ++b) {
+        fp ^= (value >> (8 * b)) & 0xff;
+        fp *= UINT64_C(0x100000001b3);
+    }
+    return fp;
+}
+
+static inline uint64_t fingerprint_add_double(uint64_t fp, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return fingerprint_add(fp, bits);
+}
+
+static inline uint64_t fingerprint_add_str(uint64_t fp, const char *str) {
+    fp = fingerprint_add(fp, strlen(str));
+    for (; *str != '\0'; ++str) {
+        fp = fingerprint_add(fp, (unsigned char)*str);
+    }
+    return fp;
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include <libfirm/adt/array.h>
@@ -6,12 +7,6 @@
 #include "func.h"
 #include "cfg.h"
 
-#define FUNC_NAME_LEN 25
-
-static int func_counter = 0;
-static int cfg_size = 10;
-
-static int visit_counter = 0;
 
 static func_t* new_func(void) {
     func_t* func = malloc(sizeof(func_t));
@@ -25,7 +20,7 @@ void func_add_call(func_t *func, func_t *callee) {
     //printf("%s ;; add call to %s ;; has %d calls\n", func->name, callee->name, ARR_LEN(func->calls));
 }
 
-static int func_is_dominated_core(func_t* func, func_t* dom) {
+static int func_is_dominated_core(int visit_counter, func_t* func, func_t* dom) {
     if (func->visited >= visit_counter) {
         return 0;
     } else {
@@ -43,7 +38,7 @@ static int func_is_dominated_core(func_t* func, func_t* dom) {
             return 1;
         }
 
-        if (func_is_dominated_core(callee, dom)) {
+        if (func_is_dominated_core(visit_counter, callee, dom)) {
             return 1;
         }
     }
@@ -51,41 +46,58 @@ static int func_is_dominated_core(func_t* func, func_t* dom) {
     return 0;
 }
 
-int func_is_dominated(func_t* func, func_t* dom) {
-    visit_counter++;
-    return func_is_dominated_core(func, dom);
+int func_is_dominated(gen_context_t *ctx, func_t* func, func_t* dom) {
+    ctx->func_visit_counter++;
+    return func_is_dominated_core(ctx->func_visit_counter, func, dom);
 }
 
 void destroy_func(func_t *func) {
     destroy_cfg(func->cfg);
     func->cfg = NULL;
+    DEL_ARR_F(func->calls);
+    free(func->name);
     free(func);
 }
 
-func_t* new_random_func(int n_params, int n_res) {
+func_t* new_random_func(gen_context_t *ctx, int n_params, int n_res) {
     func_t* func = new_func();
 
     // create unique name for function
     func->name = malloc(FUNC_NAME_LEN);
     func->n_params = n_params;
     func->n_res = n_res;
-    snprintf(func->name, FUNC_NAME_LEN, "r_func_%d", func_counter);
-    func_counter++;
+    snprintf(func->name, FUNC_NAME_LEN, "r_func_%d", ctx->func_counter);
+    ctx->func_counter++;
 
-    // expand functiion graph
+    // every function shapes its CFG with its own stream, so that the
+    // graphs can be expanded in any order
+    rng_seed(&func->rng, rng_next(get_ctx_stream(ctx, STREAM_CFG)));
     func->cfg = new_cfg();
-    for (int i = 0; i < fs_params.cfg.n_blocks; ++i) {
-        cfg_expand(func->cfg);
-    }
 
     return func;
 }
 
-void set_cfg_size(int n) {
-    if (n > MAX_CF_BLOCKS) {
-        fprintf(stderr, "Warning: CFG size set to maxiumum %d\n", MAX_CF_BLOCKS);
-        cfg_size = MAX_CF_BLOCKS;
-    } else {
-        cfg_size = n;
+/**
+  * Creates a function around an already shaped CFG, e.g. one read
+  * back from a corpus.
+  **/
+func_t *new_func_with_cfg(const char *name, int n_params, int n_res, cfg_t *cfg) {
+    func_t* func = new_func();
+    func->name = malloc(FUNC_NAME_LEN);
+    snprintf(func->name, FUNC_NAME_LEN, "%s", name);
+    func->n_params = n_params;
+    func->n_res = n_res;
+    func->cfg = cfg;
+    memset(&func->rng, 0, sizeof(func->rng));
+    return func;
+}
+
+/**
+  * Expands the CFG of the function to its final size.
+  * Only touches the function itself and may run on any thread.
+  **/
+void func_expand_cfg(func_t *func) {
+    for (int i = 0; i < fs_params.cfg.n_blocks; ++i) {
+        cfg_expand(&func->rng, func->cfg);
     }
 }
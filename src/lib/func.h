@@ -3,6 +3,11 @@
 
 #include "cfg.h"
 
+#define FUNC_NAME_LEN 25
+// Arity of every generated function, the only one the resolver supports
+#define FUNC_N_PARAMS 1
+#define FUNC_N_RES 1
+
 typedef struct func_t {
     char *name;
     cfg_t *cfg;
@@ -11,12 +16,14 @@ typedef struct func_t {
     int n_res;
     int visited;
     struct func_t **calls;
+    rng_t rng;          /**< stream for the shape of the CFG */
 } func_t;
 
-func_t *new_random_func(int n_params, int n_res);
+func_t *new_random_func(gen_context_t *ctx, int n_params, int n_res);
+func_t *new_func_with_cfg(const char *name, int n_params, int n_res, cfg_t *cfg);
+void func_expand_cfg(func_t *func);
 void destroy_func(func_t *func);
-void set_cfg_size(int n);
-int func_is_dominated(func_t* func, func_t* dom);
+int func_is_dominated(gen_context_t *ctx, func_t* func, func_t* dom);
 void func_add_call(func_t *func, func_t *callee);
 #endif
 
@@ -1,5 +1,19 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "optimizations.h"
 
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include <libfirm/adt/array.h>
+
+#include "../cmdline/parameters.h"
+
 typedef enum opt_target {
 	OPT_TARGET_IRG, /**< optimization function works on a single graph */
 	OPT_TARGET_IRP  /**< optimization function works on the complete program */
@@ -77,12 +91,240 @@ static opt_config_t opts[] = {
 #undef IRG
 };
 
-ir_graph *get_optimized_graph(ir_graph *irg) {
-    for (size_t i = 0; i < sizeof(opts)  / sizeof(opts[0]); ++i) {
-        opt_config_t config = opts[i];
-        if (config.target == OPT_TARGET_IRG) {
-            config.u.transform_irg(irg);
+#define N_OPTS (sizeof(opts) / sizeof(opts[0]))
+
+size_t get_n_opts(void) {
+    return N_OPTS;
+}
+
+const char *get_opt_name(size_t idx) {
+    assert(idx < N_OPTS);
+    return opts[idx].name;
+}
+
+/**
+  * Looks up an optimization by its name
+  * @return Index into the optimization table or -1 if there is none
+  **/
+int find_opt(const char *name) {
+    for (size_t i = 0; i < N_OPTS; ++i) {
+        if (strcmp(opts[i].name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static double get_clock(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long get_peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static void count_nodes_walker(ir_node *node, void *env) {
+    (void)node;
+    size_t *n_nodes = (size_t*)env;
+    *n_nodes += 1;
+}
+
+/**
+  * Counts the nodes reachable in all graphs of the program
+  **/
+static size_t count_nodes(void) {
+    size_t n_nodes = 0;
+    for (size_t i = 0, n = get_irp_n_irgs(); i < n; ++i) {
+        irg_walk_graph(get_irp_irg(i), count_nodes_walker, NULL, &n_nodes);
+    }
+    return n_nodes;
+}
+
+/**
+  * Sums up the node indices handed out by all graphs of the program,
+  * which grows with every node allocated on the graph obstacks.
+  **/
+static size_t count_node_allocations(void) {
+    size_t n_allocs = 0;
+    for (size_t i = 0, n = get_irp_n_irgs(); i < n; ++i) {
+        n_allocs += get_irg_last_idx(get_irp_irg(i));
+    }
+    return n_allocs;
+}
+
+/**
+  * Applies an optimization to every graph of the program
+  * (or once to the whole program) and verifies the result.
+  * @param stats Receives the measurements of the pass, may be NULL
+  * @return false if a graph does not verify afterwards
+  **/
+bool apply_opt(size_t idx, opt_stats_t *stats) {
+    assert(idx < N_OPTS);
+    opt_config_t const *config = &opts[idx];
+
+    size_t allocs_before = 0;
+    long   rss_before    = 0;
+    if (stats != NULL) {
+        stats->nodes_before = count_nodes();
+        allocs_before       = count_node_allocations();
+        rss_before          = get_peak_rss_kb();
+        stats->wall_time    = get_clock(CLOCK_MONOTONIC);
+        stats->cpu_time     = get_clock(CLOCK_PROCESS_CPUTIME_ID);
+    }
+
+    if (config->target == OPT_TARGET_IRG) {
+        for (size_t i = 0, n = get_irp_n_irgs(); i < n; ++i) {
+            config->u.transform_irg(get_irp_irg(i));
         }
+    } else {
+        config->u.transform_irp();
     }
-    return irg;
+
+    if (stats != NULL) {
+        stats->cpu_time        = get_clock(CLOCK_PROCESS_CPUTIME_ID) - stats->cpu_time;
+        stats->wall_time       = get_clock(CLOCK_MONOTONIC) - stats->wall_time;
+        stats->peak_rss_growth = get_peak_rss_kb() - rss_before;
+        stats->nodes_allocated = count_node_allocations() - allocs_before;
+        stats->nodes_after     = count_nodes();
+    }
+
+    if (config->flags & OPT_FLAG_NO_VERIFY) {
+        return true;
+    }
+    bool valid = true;
+    for (size_t i = 0, n = get_irp_n_irgs(); i < n; ++i) {
+        valid &= irg_verify(get_irp_irg(i)) != 0;
+    }
+    return valid;
+}
+
+/**
+  * Parses a comma separated list of optimization names,
+  * "all" selects the whole table.
+  * @return Flexible array of table indices or NULL if a name is unknown
+  **/
+size_t *parse_opt_list(const char *passes) {
+    size_t *list = NEW_ARR_F(size_t, 0);
+    if (strcmp(passes, "all") == 0) {
+        for (size_t i = 0; i < N_OPTS; ++i) {
+            ARR_APP1(size_t, list, i);
+        }
+        return list;
+    }
+
+    char *names = malloc(strlen(passes) + 1);
+    strcpy(names, passes);
+    for (char *name = strtok(names, ","); name != NULL; name = strtok(NULL, ",")) {
+        int idx = find_opt(name);
+        if (idx < 0) {
+            fprintf(stderr, "unknown optimization '%s'\n", name);
+            DEL_ARR_F(list);
+            list = NULL;
+            break;
+        }
+        ARR_APP1(size_t, list, (size_t)idx);
+    }
+    free(names);
+    return list;
+}
+
+/**
+  * Writes the string as JSON string literal, escaping quotes,
+  * backslashes and control characters
+  **/
+static void print_json_string(FILE *out, const char *str) {
+    putc('"', out);
+    for (; *str != '\0'; ++str) {
+        unsigned char c = (unsigned char)*str;
+        if (c == '"' || c == '\\') {
+            fprintf(out, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            putc(c, out);
+        }
+    }
+    putc('"', out);
+}
+
+/**
+  * Writes the measurements of an optimization as one JSON object per line
+  **/
+void print_opt_stats(FILE *out, size_t idx, const opt_stats_t *stats) {
+    assert(idx < N_OPTS);
+    fputs("{\"strid\": ", out);
+    print_json_string(out, fs_params.prog.strid);
+    fprintf(out,
+        ", \"seed\": %d, \"pass\": \"%s\", "
+        "\"wall_time\": %.9f, \"cpu_time\": %.9f, "
+        "\"nodes_before\": %zu, \"nodes_after\": %zu, "
+        "\"nodes_allocated\": %zu, \"peak_rss_growth_kb\": %ld}\n",
+        fs_params.prog.seed, opts[idx].name,
+        stats->wall_time, stats->cpu_time,
+        stats->nodes_before, stats->nodes_after,
+        stats->nodes_allocated, stats->peak_rss_growth);
+    fflush(out);
+}
+
+// Optimization currently run by run_opt_pipeline()
+static const char *volatile running_opt = NULL;
+// Printed after the crashed optimization, see set_opt_crash_note()
+static const char *volatile crash_note = NULL;
+
+void set_opt_crash_note(const char *note) {
+    crash_note = note;
+}
+
+/**
+  * Signal handler naming the optimization which crashed
+  **/
+static void report_crashed_opt(int sig) {
+    static const char prefix[] = "crash in optimization ";
+    const char *name = running_opt;
+    if (name != NULL) {
+        ssize_t res = write(STDERR_FILENO, prefix, sizeof(prefix) - 1);
+        res = write(STDERR_FILENO, name, strlen(name));
+        res = write(STDERR_FILENO, "\n", 1);
+        const char *note = crash_note;
+        if (note != NULL) {
+            res = write(STDERR_FILENO, note, strlen(note));
+            res = write(STDERR_FILENO, "\n", 1);
+        }
+        (void)res;
+    }
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/**
+  * Applies the optimizations of the list one after another and verifies
+  * the program after each of them. The first optimization producing an
+  * invalid graph, or crashing, is reported by name on stderr.
+  * @return false if an optimization produced an invalid graph
+  **/
+bool run_opt_pipeline(const size_t *list, FILE *stats_out) {
+    signal(SIGABRT, report_crashed_opt);
+    signal(SIGSEGV, report_crashed_opt);
+
+    bool valid = true;
+    for (size_t i = 0; i < ARR_LEN(list) && valid; ++i) {
+        opt_stats_t stats;
+        running_opt = opts[list[i]].name;
+        valid = apply_opt(list[i], stats_out != NULL ? &stats : NULL);
+        if (stats_out != NULL) {
+            print_opt_stats(stats_out, list[i], &stats);
+        }
+        if (!valid) {
+            fprintf(stderr, "optimization %s produced an invalid graph\n", running_opt);
+        }
+    }
+    running_opt = NULL;
+
+    signal(SIGABRT, SIG_DFL);
+    signal(SIGSEGV, SIG_DFL);
+    return valid;
 }
@@ -4,6 +4,34 @@
 #include <libfirm/firm.h>
 #include <libfirm/iroptimize.h>
 
-ir_graph *get_optimized_graph(ir_graph *irg);
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Measurements taken while applying an optimization
+ */
+typedef struct opt_stats_t {
+    double wall_time;       /**< elapsed seconds */
+    double cpu_time;        /**< process CPU seconds */
+    size_t nodes_before;    /**< reachable nodes before the pass */
+    size_t nodes_after;     /**< reachable nodes after the pass */
+    size_t nodes_allocated; /**< nodes allocated on the graph obstacks */
+    long peak_rss_growth;   /**< growth of the peak resident set in KiB */
+} opt_stats_t;
+
+size_t get_n_opts(void);
+const char *get_opt_name(size_t idx);
+int find_opt(const char *name);
+bool apply_opt(size_t idx, opt_stats_t *stats);
+void print_opt_stats(FILE *out, size_t idx, const opt_stats_t *stats);
+size_t *parse_opt_list(const char *passes);
+bool run_opt_pipeline(const size_t *list, FILE *stats_out);
+
+/**
+ * Sets a line printed on stderr after the name of a crashing optimization,
+ * e.g. how to dump the graphs, or NULL for none. The string is not copied.
+ */
+void set_opt_crash_note(const char *note);
 
 #endif
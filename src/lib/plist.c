@@ -3,22 +3,27 @@
 
 #include "plist.h"
 
-static ptr_lmem_t *new_ptr_lmem(void *ptr) {
-    ptr_lmem_t *lmem = malloc(sizeof(ptr_lmem_t));
+static ptr_lmem_t *new_ptr_lmem(struct obstack *obst, void *ptr) {
+    ptr_lmem_t *lmem = OALLOC(obst, ptr_lmem_t);
     INIT_LIST_HEAD(&lmem->head);
     lmem->ptr = ptr;
     return lmem;
 }
 
-plist_t* new_plist() {
-    plist_t *list = malloc(sizeof(plist_t));
+/**
+  * Creates a list on the given obstack. Members are allocated on it as
+  * well and released together with the obstack.
+  **/
+plist_t* new_plist(struct obstack *obst) {
+    plist_t *list = OALLOC(obst, plist_t);
     INIT_LIST_HEAD(&list->head);
     list->count = 0;
+    list->obst  = obst;
     return list;
 }
 
 void plist_add(plist_t *list, void *ptr) {
-    ptr_lmem_t *lmem = new_ptr_lmem(ptr);
+    ptr_lmem_t *lmem = new_ptr_lmem(list->obst, ptr);
     list_add_tail(&lmem->head, &list->head);
     lmem->list = list;
     list->count += 1;
@@ -35,11 +40,6 @@ void ptr_lmem_delete(ptr_lmem_t *lmem) {
     lmem->list = NULL;
 }
 
-void ptr_lmem_free(ptr_lmem_t *lmem) {
-    assert(lmem->list == NULL);
-    free(lmem);
-}
-
 int plist_delete(plist_t* list, void *ptr) {
     int deletions = 0;
     for_each_ptr_lmem(list, lmem) {
@@ -4,6 +4,8 @@
 #include <libfirm/firm.h>
 #include <libfirm/adt/list.h>
 
+#include "../adt/obst.h"
+
 #define for_each_ptr_lmem(list, iterator) list_for_each_entry(ptr_lmem_t, iterator, (&list->head), head)
 
 struct plist_t;
@@ -17,13 +19,13 @@ typedef struct ptr_lmem_t {
 typedef struct plist_t {
     struct list_head head; 
     int count;
+    struct obstack *obst;   /**< holds the list and its members */
 } plist_t;
 
 
-plist_t* new_plist(void);
+plist_t* new_plist(struct obstack *obst);
 void plist_add(plist_t *list, void *ptr);
 void ptr_lmem_delete(ptr_lmem_t *lmem);
-void ptr_lmem_free(ptr_lmem_t *lmem);
 int plist_delete(plist_t* list, void *ptr);
 
 #endif
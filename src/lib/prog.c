@@ -1,22 +1,113 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <libfirm/adt/array.h>
 
 #include "../cmdline/parameters.h"
 #include "prog.h"
+#include "random.h"
 
-prog_t *new_random_prog(void) {
-    int n_funcs = fs_params.prog.n_funcs;
+/**
+  * Work shared by the threads expanding the function CFGs
+  **/
+typedef struct expand_pool_t {
+    pthread_mutex_t lock;
+    func_t **funcs;
+    size_t next;        /**< index of the next function to expand */
+} expand_pool_t;
+
+static void *expand_worker(void *data) {
+    expand_pool_t *pool = data;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        size_t idx = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if (idx >= ARR_LEN(pool->funcs)) {
+            return NULL;
+        }
+        func_expand_cfg(pool->funcs[idx]);
+    }
+}
+
+/**
+  * Expands the CFGs of all functions, using up to fs_params.run.jobs
+  * threads. As every function draws from its own stream, the result
+  * does not depend on the number of threads.
+  **/
+static void expand_funcs(func_t **funcs) {
+    size_t n_funcs = ARR_LEN(funcs);
+    size_t n_jobs  = fs_params.run.jobs > 1 ? (size_t)fs_params.run.jobs : 1;
+    if (n_jobs > n_funcs) {
+        n_jobs = n_funcs;
+    }
+    if (n_jobs <= 1) {
+        for (size_t i = 0; i < n_funcs; ++i) {
+            func_expand_cfg(funcs[i]);
+        }
+        return;
+    }
+
+    expand_pool_t pool;
+    pthread_mutex_init(&pool.lock, NULL);
+    pool.funcs = funcs;
+    pool.next  = 0;
+
+    pthread_t threads[n_jobs - 1];
+    size_t n_threads = 0;
+    for (; n_threads < n_jobs - 1; ++n_threads) {
+        if (pthread_create(&threads[n_threads], NULL, expand_worker, &pool) != 0) {
+            break;
+        }
+    }
+    // The calling thread takes part, so it also copes with failed creations
+    expand_worker(&pool);
+    for (size_t i = 0; i < n_threads; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool.lock);
+}
+
+/**
+  * Creates a program without functions
+  **/
+prog_t *new_prog(gen_context_t *ctx) {
     prog_t *prog = malloc(sizeof(prog_t));
-    prog->funcs = NEW_ARR_F(func_t*, n_funcs);
+    assert(prog != NULL);
+    prog->ctx   = ctx;
+    prog->funcs = NEW_ARR_F(func_t*, 0);
+    return prog;
+}
+
+prog_t *new_random_prog(gen_context_t *ctx) {
+    int n_funcs = fs_params.prog.n_funcs;
+    prog_t *prog = new_prog(ctx);
     for (int i = 0; i < n_funcs; ++i) {
-        func_t *func = new_random_func(1, 1);
+        func_t *func = new_random_func(ctx, FUNC_N_PARAMS, FUNC_N_RES);
         if (i == 0) {
-            func->name = "_main";
+            snprintf(func->name, FUNC_NAME_LEN, "_main");
         }
-        prog->funcs[i] = func;
+        ARR_APP1(func_t*, prog->funcs, func);
     }
+    expand_funcs(prog->funcs);
     return prog;
 }
 
+/**
+  * Frees the program together with its functions.
+  * The libFirm graphs are owned by the irp and the context by
+  * its creator, neither of them is touched.
+  **/
+void destroy_prog(prog_t *prog) {
+    for (size_t i = 0; i < ARR_LEN(prog->funcs); ++i) {
+        destroy_func(prog->funcs[i]);
+    }
+    DEL_ARR_F(prog->funcs);
+    free(prog);
+}
+
 /**
   * Returns random function associated with program,
   * which is not the main function.
@@ -24,7 +115,7 @@ prog_t *new_random_prog(void) {
 func_t *prog_get_random_func(prog_t* prog) {
     func_t *func = NULL;
     if (ARR_LEN(prog->funcs) > 1) {
-        int index = (rand() % (ARR_LEN(prog->funcs) - 1)) + 1;
+        int index = rng_below(get_ctx_stream(prog->ctx, STREAM_DATA), ARR_LEN(prog->funcs) - 1) + 1;
         func = prog->funcs[index];
         assert(func);
     }
@@ -5,10 +5,13 @@
 #include "func.h"
 
 typedef struct prog_t {
+    gen_context_t *ctx;  /**< context the program is generated in */
     func_t **funcs;
 } prog_t;
 
-prog_t *new_random_prog(void);
+prog_t *new_prog(gen_context_t *ctx);
+prog_t *new_random_prog(gen_context_t *ctx);
+void destroy_prog(prog_t *prog);
 func_t *prog_get_random_func(prog_t* prog);
 
 #endif
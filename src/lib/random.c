@@ -1,7 +1,77 @@
+#include <assert.h>
+
 #include "random.h"
 
-double get_random_percentage(void) {
-    return (double)rand()/(((double)RAND_MAX)/100.0);
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += UINT64_C(0x9e3779b97f4a7c15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+  * Seeds the generator, expanding the seed with splitmix64
+  * as recommended by the xoshiro authors.
+  **/
+void rng_seed(rng_t *rng, uint64_t seed) {
+    for (int i = 0; i < 4; ++i) {
+        rng->state[i] = splitmix64(&seed);
+    }
+}
+
+uint64_t rng_next(rng_t *rng) {
+    uint64_t *s = rng->state;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+/**
+  * Returns a uniformly distributed number in [0, bound)
+  * (Lemire's multiply and reject method, free of modulo bias).
+  **/
+uint32_t rng_below(rng_t *rng, uint32_t bound) {
+    assert(bound > 0);
+    uint64_t m = (rng_next(rng) >> 32) * bound;
+    uint32_t low = (uint32_t)m;
+    if (low < bound) {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (rng_next(rng) >> 32) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+/**
+  * Returns a uniformly distributed number in [0, 1)
+  **/
+double rng_double(rng_t *rng) {
+    return (double)(rng_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+  * Seeds every stream from a single seed.
+  **/
+void seed_random_streams(rng_t streams[N_STREAMS], uint64_t seed) {
+    for (int i = 0; i < N_STREAMS; ++i) {
+        rng_seed(&streams[i], splitmix64(&seed));
+    }
+}
+
+double get_random_percentage(rng_t *rng) {
+    return rng_double(rng) * 100.0;
 }
 
 void get_interpolation_prefix_sum_table(int n, double probs[][2], double result[], double factor) {
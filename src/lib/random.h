@@ -1,9 +1,35 @@
 #ifndef RANDOM_H
 #define RANDOM_H
 
+#include <stdint.h>
 #include <stdlib.h>
 
-double get_random_percentage(void);
+/**
+  * State of a xoshiro256** generator
+  **/
+typedef struct rng_t {
+    uint64_t state[4];
+} rng_t;
+
+/**
+  * Independent streams of random decisions, so that e.g. changing how
+  * data nodes are chosen does not alter the shape of the generated CFGs.
+  **/
+typedef enum random_stream_t {
+    STREAM_CFG,     /**< shape of the control flow graphs */
+    STREAM_TYPES,   /**< type universe */
+    STREAM_DATA,    /**< data nodes chosen by the resolvers */
+    N_STREAMS
+} random_stream_t;
+
+void rng_seed(rng_t *rng, uint64_t seed);
+uint64_t rng_next(rng_t *rng);
+uint32_t rng_below(rng_t *rng, uint32_t bound);
+double rng_double(rng_t *rng);
+
+void seed_random_streams(rng_t streams[N_STREAMS], uint64_t seed);
+
+double get_random_percentage(rng_t *rng);
 void get_interpolation_prefix_sum_table(int n, double probs[][2], double result[], double factor);
 
 #endif
@@ -0,0 +1,198 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libfirm/adt/array.h>
+
+#include "reach.h"
+#include "../adt/pdeq.h"
+
+#define BITS_PER_WORD (sizeof(unsigned) * 8)
+
+/**
+  * Slot of a registered node
+  **/
+typedef struct reach_slot_t {
+    int block;          /**< CF block index, -1 if the node is not registered */
+    unsigned slot;
+} reach_slot_t;
+
+/**
+  * Reachability index of a single CF block
+  **/
+typedef struct reach_block_t {
+    ir_node **nodes;    /**< registered nodes by slot */
+    unsigned **desc;    /**< bitset of the slots reached by every slot */
+    size_t n_words;     /**< length of the bitsets */
+} reach_block_t;
+
+struct reach_t {
+    int n_blocks;
+    reach_block_t *blocks;
+    reach_slot_t *slots;    /**< slots by node index */
+};
+
+reach_t *new_reach(int n_blocks) {
+    reach_t *reach = malloc(sizeof(reach_t));
+    assert(reach != NULL);
+    reach->n_blocks = n_blocks;
+    reach->blocks   = calloc(n_blocks, sizeof(reach_block_t));
+    assert(reach->blocks != NULL);
+    for (int i = 0; i < n_blocks; ++i) {
+        reach->blocks[i].nodes = NEW_ARR_F(ir_node*, 0);
+        reach->blocks[i].desc  = NEW_ARR_F(unsigned*, 0);
+    }
+    reach->slots = NEW_ARR_F(reach_slot_t, 0);
+    return reach;
+}
+
+void free_reach(reach_t *reach) {
+    for (int i = 0; i < reach->n_blocks; ++i) {
+        reach_block_t *block = &reach->blocks[i];
+        for (size_t j = 0; j < ARR_LEN(block->desc); ++j) {
+            free(block->desc[j]);
+        }
+        DEL_ARR_F(block->desc);
+        DEL_ARR_F(block->nodes);
+    }
+    free(reach->blocks);
+    DEL_ARR_F(reach->slots);
+    free(reach);
+}
+
+static const reach_slot_t *get_slot(const reach_t *reach, const ir_node *node) {
+    static const reach_slot_t unregistered = { -1, 0 };
+    unsigned idx = get_irn_idx(node);
+    return idx < ARR_LEN(reach->slots) ? &reach->slots[idx] : &unregistered;
+}
+
+static inline bool desc_has(const unsigned *desc, unsigned slot) {
+    return (desc[slot / BITS_PER_WORD] >> (slot % BITS_PER_WORD)) & 1;
+}
+
+static inline void desc_set(unsigned *desc, unsigned slot) {
+    desc[slot / BITS_PER_WORD] |= 1u << (slot % BITS_PER_WORD);
+}
+
+static void desc_or(unsigned *desc, const unsigned *other, size_t n_words) {
+    for (size_t i = 0; i < n_words; ++i) {
+        desc[i] |= other[i];
+    }
+}
+
+/**
+  * Adds the slots reached over the operands of node to desc.
+  * Unregistered nodes are freshly created ones (or nodes without
+  * data inputs like Const), their operands are collected as well,
+  * using a worklist instead of recursion.
+  **/
+static void collect_desc(const reach_t *reach, int block, ir_node *node, unsigned *desc) {
+    pdeq *worklist = new_pdeq();
+    for (int i = 0, n = get_irn_arity(node); i < n; ++i) {
+        pdeq_putr(worklist, get_irn_n(node, i));
+    }
+
+    while (!pdeq_empty(worklist)) {
+        ir_node *op = pdeq_getr(worklist);
+        const reach_slot_t *slot = get_slot(reach, op);
+        if (slot->block == block) {
+            desc_set(desc, slot->slot);
+            if (!is_Phi(op)) {
+                desc_or(desc, reach->blocks[block].desc[slot->slot], reach->blocks[block].n_words);
+            }
+        } else if (slot->block < 0 && !is_Phi(op)) {
+            for (int i = 0, n = get_irn_arity(op); i < n; ++i) {
+                pdeq_putr(worklist, get_irn_n(op, i));
+            }
+        }
+        // Nodes registered in other blocks are only reachable over Phi nodes
+    }
+
+    del_pdeq(worklist);
+}
+
+/**
+  * Registers a node with the CF block and computes the slots it reaches.
+  * Nodes are registered once, further calls are ignored.
+  **/
+void reach_add_node(reach_t *reach, int block, ir_node *node) {
+    assert(block >= 0 && block < reach->n_blocks);
+    unsigned idx = get_irn_idx(node);
+    if (idx >= ARR_LEN(reach->slots)) {
+        size_t old_len = ARR_LEN(reach->slots);
+        size_t new_len = idx + 1 > 2 * old_len ? idx + 1 : 2 * old_len;
+        ARR_RESIZE(reach_slot_t, reach->slots, new_len);
+        for (size_t i = old_len; i < new_len; ++i) {
+            reach->slots[i].block = -1;
+        }
+    }
+    if (reach->slots[idx].block >= 0) {
+        return;
+    }
+
+    // Grow the bitsets of the block if the new slot does not fit
+    reach_block_t *rblock = &reach->blocks[block];
+    unsigned slot = ARR_LEN(rblock->nodes);
+    if (slot >= rblock->n_words * BITS_PER_WORD) {
+        size_t n_words = rblock->n_words == 0 ? 1 : 2 * rblock->n_words;
+        for (size_t i = 0; i < ARR_LEN(rblock->desc); ++i) {
+            rblock->desc[i] = realloc(rblock->desc[i], n_words * sizeof(unsigned));
+            assert(rblock->desc[i] != NULL);
+            memset(rblock->desc[i] + rblock->n_words, 0,
+                   (n_words - rblock->n_words) * sizeof(unsigned));
+        }
+        rblock->n_words = n_words;
+    }
+
+    unsigned *desc = calloc(rblock->n_words, sizeof(unsigned));
+    assert(desc != NULL);
+    collect_desc(reach, block, node, desc);
+    ARR_APP1(ir_node*, rblock->nodes, node);
+    ARR_APP1(unsigned*, rblock->desc, desc);
+    reach->slots[idx].block = block;
+    reach->slots[idx].slot  = slot;
+}
+
+/**
+  * Updates the index before old is exchanged with nw:
+  * every node reaching old now reaches nw and whatever nw reaches.
+  **/
+void reach_exchange(reach_t *reach, int block, ir_node *old, ir_node *nw) {
+    const reach_slot_t *old_slot = get_slot(reach, old);
+    assert(old_slot->block == block);
+    unsigned old_idx = old_slot->slot;
+
+    reach_add_node(reach, block, nw);
+    const reach_slot_t *new_slot = get_slot(reach, nw);
+    if (new_slot->block != block) {
+        // Only nodes of other blocks reached over Phi nodes,
+        // so nw does not extend any path of this block
+        return;
+    }
+
+    reach_block_t *rblock  = &reach->blocks[block];
+    unsigned       new_idx = new_slot->slot;
+    const unsigned *new_desc = is_Phi(nw) ? NULL : rblock->desc[new_idx];
+    for (size_t i = 0; i < ARR_LEN(rblock->desc); ++i) {
+        unsigned *desc = rblock->desc[i];
+        if (!desc_has(desc, old_idx)) {
+            continue;
+        }
+        desc_set(desc, new_idx);
+        if (new_desc != NULL && desc != new_desc) {
+            desc_or(desc, new_desc, rblock->n_words);
+        }
+    }
+}
+
+/**
+  * @return true if node reaches target
+  **/
+bool reach_reaches(const reach_t *reach, const ir_node *node, const ir_node *target) {
+    const reach_slot_t *node_slot   = get_slot(reach, node);
+    const reach_slot_t *target_slot = get_slot(reach, target);
+    if (node_slot->block < 0 || node_slot->block != target_slot->block) {
+        return false;
+    }
+    const reach_block_t *rblock = &reach->blocks[node_slot->block];
+    return desc_has(rblock->desc[node_slot->slot], target_slot->slot);
+}
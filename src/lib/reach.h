@@ -0,0 +1,29 @@
+#ifndef REACH_H
+#define REACH_H
+
+#include <stdbool.h>
+#include <libfirm/firm.h>
+
+/**
+  * Reachability index over the nodes of the CF blocks of a function.
+  *
+  * A node reaches another one, if there is a path over its operands
+  * (without the block input) which does not pass through a Phi node.
+  * Only the Phi node itself may start such a path. This is the relation
+  * deciding whether a node can replace a temporary without creating
+  * a cycle inside a block.
+  *
+  * Every registered node gets a slot in the index of its CF block
+  * and a bitset of the slots it reaches. The bitsets are updated
+  * whenever a registered node is exchanged, so queries are a bit test.
+  **/
+typedef struct reach_t reach_t;
+
+reach_t *new_reach(int n_blocks);
+void free_reach(reach_t *reach);
+
+void reach_add_node(reach_t *reach, int block, ir_node *node);
+void reach_exchange(reach_t *reach, int block, ir_node *old, ir_node *nw);
+bool reach_reaches(const reach_t *reach, const ir_node *node, const ir_node *target);
+
+#endif
@@ -1,30 +1,32 @@
 #include <libfirm/firm.h>
+#include <libfirm/adt/array.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 
+#include "../adt/cpmap.h"
+#include "../adt/hashptr.h"
+#include "../adt/pdeq.h"
 #include "../cmdline/parameters.h"
 #include "func.h"
 #include "cfb.h"
+#include "fingerprint.h"
 #include "resolve.h"
 #include "utils.h"
 #include "random.h"
+#include "reach.h"
 #include "statistics.h"
 #include "types.h"
 
-static ir_node* adopt_operator(void);
-static ir_node* adopt_load(void);
-static ir_node* adopt_const(void);
-static ir_node* adopt_phi(void);
-static ir_node* adopt_existing(void);
-static ir_node* adopt_fcall(void);
-
-// Resolution context
-static prog_t *current_prog = NULL;
-static func_t *current_func = NULL;
-static cfg_t *current_cfg = NULL;
-static cfb_t *current_cfb = NULL;
-static temp_t *current_temp = NULL;
+static ir_node* adopt_operator(gen_context_t *ctx);
+static ir_node* adopt_load(gen_context_t *ctx);
+static ir_node* adopt_const(gen_context_t *ctx);
+static ir_node* adopt_phi(gen_context_t *ctx);
+static ir_node* adopt_existing(gen_context_t *ctx);
+static ir_node* adopt_fcall(gen_context_t *ctx);
+static ir_node* new_operand(gen_context_t *ctx, ir_type *type);
+static void seed_store(gen_context_t *ctx, ir_node *node, ir_type *type);
 
 // Sliding probablilites
 
@@ -33,19 +35,34 @@ typedef struct sliding_prob_t {
     double end;
 } sliding_prob_t;
 
-typedef ir_node* (*adopt_func_t)(void);
+typedef ir_node* (*adopt_func_t)(gen_context_t *ctx);
 
 typedef struct resolver_t {
     adopt_func_t func;
     sliding_prob_t prob;
 } resolver_t;
 
+// Number of steps the fill factor of a CF block is quantized to
+#define N_FILL_LEVELS 16
+
+/**
+  * Walker alias table for drawing a resolver in constant time.
+  * Column i keeps resolver i with probability threshold[i] / 2^32,
+  * otherwise resolver alias[i] is used.
+  **/
+typedef struct alias_table_t {
+    uint64_t *threshold;
+    int *alias;
+} alias_table_t;
+
 typedef struct kind_resolver_t {
     int n_resolvers;
     resolver_t **resolvers;
-    double *ips_table;
+    alias_table_t tables[N_FILL_LEVELS + 1]; /**< per quantized fill factor */
 } kind_resolver_t;
 
+// Set up by initialize_resolve() and read-only afterwards,
+// so the tables can be shared by all generator contexts
 int n_kind_resolver;
 static kind_resolver_t **kind_resolver_arr = NULL;
 
@@ -70,8 +87,6 @@ static kind_resolver_t *new_kind_resolver(int n_resolvers) {
     kind_resolver->n_resolvers = n_resolvers;
     kind_resolver->resolvers = calloc(n_resolvers, sizeof(resolver_t*));
     assert(kind_resolver->resolvers != NULL);
-    kind_resolver->ips_table = calloc(n_resolvers, sizeof(double));
-    assert(kind_resolver->ips_table != NULL);
     return kind_resolver;
 }
 
@@ -86,60 +101,183 @@ static resolver_t *new_resolver(adopt_func_t func, double start, double end) {
     return resolver;
 }
 
-static void update_ips_table(kind_resolver_t *kind_resolver) {
-    int n_nodes   = current_cfb == NULL ? 1 : current_cfb->n_nodes;
-    int max_nodes = fs_params.cfb.n_nodes;
-    double factor = n_nodes >= max_nodes ?
-        1.0f : ((double)n_nodes) / ((double)max_nodes);
+/**
+  * Builds the alias table of the kind resolver for the given fill factor.
+  * The resolver probabilities are interpolated by the factor and
+  * accumulated like percentages, a resolver whose prefix sum exceeds
+  * 100 only gets the remainder, the following ones are never chosen.
+  **/
+static void init_alias_table(alias_table_t *table, const kind_resolver_t *kind_resolver, double factor) {
+    int n = kind_resolver->n_resolvers;
+    double scaled[n];
+    int small[n];
+    int large[n];
+    int n_small = 0;
+    int n_large = 0;
+
     double prefix_sum = 0.0;
-    for (int i = 0; i < kind_resolver->n_resolvers; ++i) {
+    double covered    = 0.0;
+    for (int i = 0; i < n; ++i) {
         resolver_t *resolver = kind_resolver->resolvers[i];
         double diff  = (resolver->prob.end  - resolver->prob.start);
-        double intpl = resolver->prob.start + diff * factor;
-        prefix_sum += intpl;
-        kind_resolver->ips_table[i] = prefix_sum;
+        prefix_sum  += resolver->prob.start + diff * factor;
+        double upto  = prefix_sum < 100.0 ? prefix_sum : 100.0;
+        scaled[i]    = (upto - covered) * n / 100.0;
+        covered      = upto;
+        if (scaled[i] < 1.0) {
+            small[n_small++] = i;
+        } else {
+            large[n_large++] = i;
+        }
+    }
+    assert(prefix_sum >= 100.0);
+
+    table->threshold = malloc(n * sizeof(uint64_t));
+    table->alias     = malloc(n * sizeof(int));
+    assert(table->threshold != NULL && table->alias != NULL);
+
+    // Fill the columns of the small entries with the large ones
+    while (n_small > 0 && n_large > 0) {
+        int s = small[--n_small];
+        int l = large[--n_large];
+        table->threshold[s] = (uint64_t)(scaled[s] * 4294967296.0);
+        table->alias[s]     = l;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            small[n_small++] = l;
+        } else {
+            large[n_large++] = l;
+        }
+    }
+    // Remaining entries fill their column up to rounding errors
+    while (n_large > 0) {
+        int l = large[--n_large];
+        table->threshold[l] = UINT64_C(1) << 32;
+        table->alias[l]     = l;
+    }
+    while (n_small > 0) {
+        int s = small[--n_small];
+        table->threshold[s] = UINT64_C(1) << 32;
+        table->alias[s]     = s;
+    }
+}
+
+static void init_alias_tables(kind_resolver_t *kind_resolver) {
+    for (int level = 0; level <= N_FILL_LEVELS; ++level) {
+        init_alias_table(&kind_resolver->tables[level], kind_resolver,
+                         (double)level / N_FILL_LEVELS);
     }
 }
 
 /**
-  * Update memory path
+  * Draws a resolver of the kind, weighted by the fill factor of the
+  * current CF block.
+  * @return Index of the resolver
   **/
-static void update_memory(ir_node *mem_dummy, ir_node *mem_result) {
-    exchange(current_cfb->mem, mem_result);
-    current_cfb->mem = mem_dummy;
+static int draw_resolver(gen_context_t *ctx, const kind_resolver_t *kind_resolver) {
+    int n_nodes   = ctx->cfb == NULL ? 1 : ctx->cfb->n_nodes;
+    int max_nodes = fs_params.cfb.n_nodes;
+    int level     = n_nodes >= max_nodes ?
+        N_FILL_LEVELS : n_nodes * N_FILL_LEVELS / max_nodes;
+
+    const alias_table_t *table = &kind_resolver->tables[level];
+    rng_t *rng = get_ctx_stream(ctx, STREAM_DATA);
+    int i = rng_below(rng, kind_resolver->n_resolvers);
+    if ((rng_next(rng) >> 32) >= table->threshold[i]) {
+        i = table->alias[i];
+    }
+    return i;
 }
 
 /**
-  * Walker function for domination check
-  * @return 0 if node is dominated otherwise 1
+  * Returns the kind resolver for temporaries of the given type,
+  * NULL for booleans, which are always resolved by a Cmp node
   **/
-static int is_dominated_core(ir_node* node, ir_node* dom) {
-    if (irn_visited(node)) {
-        return 0;
-    } else {
-        mark_irn_visited(node);
-    }
-
-    assert(node != dom);
-    // Walk over all predecessor nodes, but the block node (index -1)
-    for (int i = 0, n = get_irn_arity(node); i < n; ++i) {
-        ir_node *pred_node  = get_irn_n(node, i);
-        //ir_node *pred_block = get_irn_n(pred_node, -1);
-        // We encountered the dominator node, therefore we found a path between
-        // `node` and `dom`, which implies that `dom` is defined before `node` is.
-        if (pred_node == dom) {
-            return 1;
-        }
-        // Use-before-def does not apply to block boundary passing paths 
-        if (get_irn_opcode(pred_node) == iro_Phi) {
-            continue;
-        }
-        // Call walker function on predecessor nodes
-        if (is_dominated_core(pred_node, dom)) {
-            return 1;
-        }
+static const kind_resolver_t *get_kind_resolver(ir_type *type) {
+    if (!is_Primitive_type(type)) {
+        return kind_resolver_arr[0];
+    }
+    return get_type_mode(type) == mode_b ? NULL : kind_resolver_arr[1];
+}
+
+/**
+  * Puts the CF block on the resolution worklist, unless it is
+  * already queued
+  **/
+static void enqueue_cfb(gen_context_t *ctx, cfb_t *cfb) {
+    if (!cfb->queued) {
+        cfb->queued = 1;
+        pdeq_putr(ctx->worklist, cfb);
+    }
+}
+
+/**
+  * Adds a temporary to the CF block, registers it with the
+  * reachability index and queues the block for resolution
+  **/
+static temp_t *add_temporary(gen_context_t *ctx, cfb_t *cfb, ir_node *node, ir_type *type) {
+    temp_t *temp = cfb_add_temporary(cfb, node, type);
+    reach_add_node(ctx->reach, cfb->index, node);
+    enqueue_cfb(ctx, cfb);
+    return temp;
+}
+
+static unsigned hash_type(const void *type) {
+    return hash_ptr(type);
+}
+
+static int types_equal(const void *type1, const void *type2) {
+    return type1 == type2;
+}
+
+/**
+  * Records a resolved temporary of the CF block as candidate
+  * for adopt_existing(). The map of the CF block is created on demand,
+  * as most blocks never get a resolved temporary.
+  **/
+static void add_resolved(gen_context_t *ctx, cfb_t *cfb, ir_node *node, ir_type *type) {
+    cpmap_t *resolved = ctx->resolved[cfb->index];
+    if (resolved == NULL) {
+        resolved = malloc(sizeof(cpmap_t));
+        cpmap_init(resolved, hash_type, types_equal);
+        ctx->resolved[cfb->index] = resolved;
+    }
+    ir_node **nodes = cpmap_find(resolved, type);
+    if (nodes == NULL) {
+        nodes = NEW_ARR_F(ir_node*, 0);
+    }
+    ARR_APP1(ir_node*, nodes, node);
+    cpmap_set(resolved, type, nodes);
+}
+
+/**
+  * Records a node replacing a temporary of the current CF block
+  * and randomly stores it to memory
+  **/
+static void register_resolved(gen_context_t *ctx, ir_node *node, ir_type *type) {
+    stats_register_op(ctx, get_irn_opcode(node));
+    add_resolved(ctx, ctx->cfb, node, type);
+
+    if (rng_below(get_ctx_stream(ctx, STREAM_DATA), 8) == 1) {
+        seed_store(ctx, node, type);
     }
-    return 0;
+}
+
+/**
+  * Exchanges a node of the current CF block and updates the reachability index
+  **/
+static void exchange_node(gen_context_t *ctx, ir_node *old, ir_node *nw) {
+    reach_exchange(ctx->reach, ctx->cfb->index, old, nw);
+    exchange(old, nw);
+}
+
+/**
+  * Update memory path
+  **/
+static void update_memory(gen_context_t *ctx, ir_node *mem_dummy, ir_node *mem_result) {
+    reach_add_node(ctx->reach, ctx->cfb->index, mem_dummy);
+    exchange_node(ctx, ctx->cfb->mem, mem_result);
+    ctx->cfb->mem = mem_dummy;
 }
 
 /**
@@ -147,65 +285,67 @@ static int is_dominated_core(ir_node* node, ir_node* dom) {
   * within block boundaries.
   * @return 0 if node is dominated otherwise 1
   **/
-static int is_dominated(ir_node* node, ir_node* dom) {
-    inc_irg_visited(get_irn_irg(node));
-    int res =  is_dominated_core(node, dom);
-    return res;
+static int is_dominated(gen_context_t *ctx, ir_node* node, ir_node* dom) {
+    return reach_reaches(ctx->reach, node, dom);
 }
 
-static func_bin_op_t get_random_bin_op(void) {
-    int idx = rand() % (sizeof(bin_op_funcs) / sizeof(bin_op_funcs[0]));
+static func_bin_op_t get_random_bin_op(gen_context_t *ctx) {
+    int idx = rng_below(get_ctx_stream(ctx, STREAM_DATA), sizeof(bin_op_funcs) / sizeof(bin_op_funcs[0]));
     return bin_op_funcs[idx];
 }
 
 /**
   * Adopt operator as dummy replacement
   **/
-static ir_node *adopt_operator(void) {
-    ir_type *type = current_temp->type;
-    ir_mode* mode       = get_irn_mode(current_temp->node);
-    ir_node* left_node  = new_Dummy(mode);
-    ir_node* right_node = new_Dummy(mode);
-    cfb_add_temporary(current_cfb, left_node, type);
-    cfb_add_temporary(current_cfb, right_node, type);
+static ir_node *adopt_operator(gen_context_t *ctx) {
+    ir_type *type = ctx->temp->type;
+    ir_node* left_node  = new_operand(ctx, type);
+    ir_node* right_node = new_operand(ctx, type);
     // Return operation node
-    func_bin_op_t func = get_random_bin_op();
-    ir_node *op_node = func(current_cfb->irb, left_node, right_node);
+    func_bin_op_t func = get_random_bin_op(ctx);
+    ir_node *op_node = func(ctx->cfb->irb, left_node, right_node);
     return op_node;
 }
 
-static ir_node *adopt_conv(void) {
+static ir_node *adopt_conv(gen_context_t *ctx) {
     ir_type *new_type = NULL;
     do {
-        new_type = get_random_prim_type();
-    } while (new_type == current_temp->type);
-    ir_node *dummy    = new_Dummy(get_type_mode(new_type));
-    ir_node *conv     = new_Conv(dummy, get_irn_mode(current_temp->node));
-    cfb_add_temporary(current_cfb, dummy, new_type);
+        new_type = get_random_prim_type(get_ctx_stream(ctx, STREAM_DATA));
+    } while (new_type == ctx->temp->type);
+    ir_node *operand  = new_operand(ctx, new_type);
+    ir_node *conv     = new_Conv(operand, get_irn_mode(ctx->temp->node));
     return conv;
 }
 
 /**
-  * Adopt constant as dummy replacement
+  * Returns a random constant of the given mode
   **/
-static ir_node *adopt_const(void) {
-    assert(is_Primitive_type(current_temp->type));
-    ir_mode *mode = get_type_mode(current_temp->type);
+static ir_node *new_random_const(gen_context_t *ctx, ir_mode *mode) {
+    // 31 random bits, the range of rand() on glibc
+    long value = (long)(rng_next(get_ctx_stream(ctx, STREAM_DATA)) >> 33);
     ir_tarval *tv = mode_is_float(mode) ?
-        new_tarval_from_long_double((double)rand(), mode) :
-        new_tarval_from_long(rand(), mode);
+        new_tarval_from_long_double((long double)value, mode) :
+        new_tarval_from_long(value, mode);
     ir_node *random_const = new_Const(tv);
     return random_const;
 }
 
+/**
+  * Adopt constant as dummy replacement
+  **/
+static ir_node *adopt_const(gen_context_t *ctx) {
+    assert(is_Primitive_type(ctx->temp->type));
+    return new_random_const(ctx, get_type_mode(ctx->temp->type));
+}
+
 /**
   * Adopts pointer projected from allocation as temporary.
   * Adds no further unresolved tempoaries.
   **/
-static ir_node *adopt_alloc(void) {
+static ir_node *adopt_alloc(gen_context_t *ctx) {
     // Dertmine type size
-    assert(is_Pointer_type(current_temp->type));
-    ir_type *pointee_type = get_pointer_points_to_type(current_temp->type);
+    assert(is_Pointer_type(ctx->temp->type));
+    ir_type *pointee_type = get_pointer_points_to_type(ctx->temp->type);
     int n_bytes = -1;
     if (is_Pointer_type(pointee_type) || is_Primitive_type(pointee_type)) {
         ir_mode *mode = get_type_mode(pointee_type);
@@ -218,17 +358,17 @@ static ir_node *adopt_alloc(void) {
     ir_node *size    = new_Const(new_tarval_from_long(n_bytes, mode_Iu));
     // Alloc
     ir_node *mem_dummy = new_Dummy(mode_M);
-    ir_node *alloc = new_r_Alloc(current_cfb->irb, mem_dummy, size, 8);
+    ir_node *alloc = new_r_Alloc(ctx->cfb->irb, mem_dummy, size, 8);
 	ir_node *alloc_ptr = new_Proj(alloc, mode_P, pn_Alloc_res);
 	ir_node *alloc_mem = new_Proj(alloc, mode_M, pn_Alloc_M);
-    update_memory(mem_dummy, alloc_mem);
+    update_memory(ctx, mem_dummy, alloc_mem);
     return alloc_ptr;
 }
 
-static ir_node *adopt_member(void) {
-    ir_type *pointee_type = get_pointer_points_to_type(current_temp->type);
+static ir_node *adopt_member(gen_context_t *ctx) {
+    ir_type *pointee_type = get_pointer_points_to_type(ctx->temp->type);
     // Find fitting entity
-    ir_entity *ent = get_associated_entity(pointee_type);
+    ir_entity *ent = get_associated_entity(get_ctx_stream(ctx, STREAM_DATA), pointee_type);
     if (ent == NULL) {
         return NULL;
     }
@@ -237,38 +377,34 @@ static ir_node *adopt_member(void) {
     ir_print_type(type_name, 256, pointee_type);
 
     //printf("Found entity %s for type %s\n", get_entity_ident(ent), type_name);
-    ir_node *dummy  = new_Dummy(mode_P);
-    cfb_add_temporary(
-        current_cfb, dummy,
-        new_type_pointer(get_entity_owner(ent))
-    );
-    ir_node *member = new_Member(dummy, ent);
+    ir_node *operand = new_operand(ctx, get_pointer_type_to(get_entity_owner(ent)));
+    ir_node *member  = new_Member(operand, ent);
     return member;
 }
 
 /**
   * Adopt loading from memory as dummy replacement
   **/
-static ir_node *adopt_load(void) {
+static ir_node *adopt_load(gen_context_t *ctx) {
     if (fs_params.cfb.has_memory_ops == false) {
         return NULL;
     }
 
-    assert(is_Primitive_type(current_temp->type));
+    assert(is_Primitive_type(ctx->temp->type));
 
-    ir_type *ref_type  = new_type_pointer(current_temp->type);
+    ir_type *ref_type  = get_pointer_type_to(ctx->temp->type);
     ir_node *dummy_ptr = new_Dummy(mode_P);
-    cfb_add_temporary(current_cfb, dummy_ptr, ref_type);
+    add_temporary(ctx, ctx->cfb, dummy_ptr, ref_type);
 
     ir_node *mem_dummy = new_Dummy(mode_M);
-    ir_type *type      = current_temp->type;
+    ir_type *type      = ctx->temp->type;
     ir_mode *mode      = get_type_mode(type);
-    ir_node *load      = new_r_Load(current_cfb->irb, mem_dummy, dummy_ptr, mode, type, cons_none);
+    ir_node *load      = new_r_Load(ctx->cfb->irb, mem_dummy, dummy_ptr, mode, type, cons_none);
 
 	ir_node *load_result = new_Proj(load, mode, pn_Load_res);
 	ir_node *load_mem    = new_Proj(load, mode_M, pn_Load_M);
 
-    update_memory(mem_dummy, load_mem);
+    update_memory(ctx, mem_dummy, load_mem);
 	return load_result;
 }
 
@@ -284,19 +420,19 @@ static ir_node *get_cf_op(ir_node *n)
 /**
   * Adopt Phi node as dummy replacement
   **/
-static ir_node *adopt_phi(void) {
-    ir_mode *node_mode = get_irn_mode(current_temp->node);
+static ir_node *adopt_phi(gen_context_t *ctx) {
+    ir_mode *node_mode = get_irn_mode(ctx->temp->node);
     // We can only put a phi node, if not at starting block
-    if (current_cfb->n_predecessors > 0) {
+    if (ctx->cfb->n_predecessors > 0) {
         // Create cfb array with matching order
-        int n_blocks = get_Block_n_cfgpreds(current_cfb->irb);
+        int n_blocks = get_Block_n_cfgpreds(ctx->cfb->irb);
         cfb_t *ordered_cfb[n_blocks];
-        assert(n_blocks == current_cfb->n_predecessors);
+        assert(n_blocks == ctx->cfb->n_predecessors);
         for (int i = 0; i < n_blocks; ++i) {
-            ir_node *jmp      = get_cf_op(get_Block_cfgpred(current_cfb->irb, i));
+            ir_node *jmp      = get_cf_op(get_Block_cfgpred(ctx->cfb->irb, i));
             ir_node *ir_pred  = get_nodes_block(jmp);
-            cfb_for_each_predecessor(current_cfb, pred_it) {
-                cfb_t *it_pred = cfb_get_predecessor(current_cfb, pred_it);
+            cfb_for_each_predecessor(ctx->cfb, pred_it) {
+                cfb_t *it_pred = cfb_get_predecessor(ctx->cfb, pred_it);
                 if (it_pred->irb == ir_pred) {
                     ordered_cfb[i] = it_pred;
                     break;
@@ -307,10 +443,10 @@ static ir_node *adopt_phi(void) {
         // Create phi inputs
         ir_node *ins[n_blocks];
         for (int i = 0; i < n_blocks; ++i) {
-            ins[i] = new_Dummy(get_irn_mode(current_temp->node));
-            cfb_add_temporary(ordered_cfb[i], ins[i], current_temp->type);
+            ins[i] = new_Dummy(get_irn_mode(ctx->temp->node));
+            add_temporary(ctx, ordered_cfb[i], ins[i], ctx->temp->type);
         }
-        ir_node *new_node = new_r_Phi(current_cfb->irb, n_blocks, ins, node_mode);
+        ir_node *new_node = new_r_Phi(ctx->cfb->irb, n_blocks, ins, node_mode);
         return new_node;
     } else {
         return NULL;
@@ -318,34 +454,88 @@ static ir_node *adopt_phi(void) {
 }
 
 /**
-  * Adopt existing node as dummy replacement
+  * Returns a random resolved node of the given type in the current
+  * CF block, which does not depend on the current temporary.
+  * @return NULL if there is none
   **/
-static ir_node *adopt_existing(void) {
-    ir_node **repl = NEW_ARR_F(ir_node*, 0);
-    // Iterate over all temporaries and find fitting candidates
-    cfb_for_each_temp(current_cfb, temporary) {
-        if (
-             temporary->resolved &&
-             temporary->type == current_temp->type &&
-             !is_dominated(temporary->node, current_temp->node)
-        ) {
-            ARR_APP1(ir_node*, repl, temporary->node);
-        }
+static ir_node *find_existing(gen_context_t *ctx, ir_type *type) {
+    cpmap_t *resolved = ctx->resolved[ctx->cfb->index];
+    ir_node **nodes   = resolved != NULL ? cpmap_find(resolved, type) : NULL;
+    if (nodes == NULL) {
+        return NULL;
     }
-    // Return random candidate, if any
-    int repl_length = ARR_LEN(repl);
-    if (repl_length > 0) {
-        int repl_index = rand() % repl_length;
-        return repl[repl_index];
-    } else {
+    // Count the candidates not depending on the temporary ...
+    size_t n_repl = 0;
+    for (size_t i = 0; i < ARR_LEN(nodes); ++i) {
+        n_repl += !is_dominated(ctx, nodes[i], ctx->temp->node);
+    }
+    if (n_repl == 0) {
         return NULL;
     }
+    // ... and return a random one of them
+    size_t repl_index = rng_below(get_ctx_stream(ctx, STREAM_DATA), n_repl);
+    for (size_t i = 0; i < ARR_LEN(nodes); ++i) {
+        if (!is_dominated(ctx, nodes[i], ctx->temp->node) && repl_index-- == 0) {
+            return nodes[i];
+        }
+    }
+    assert(false);
+    return NULL;
+}
+
+/**
+  * Adopt existing node as dummy replacement
+  **/
+static ir_node *adopt_existing(gen_context_t *ctx) {
+    return find_existing(ctx, ctx->temp->type);
+}
+
+/**
+  * Creates an operand of the given type for a node replacing the
+  * current temporary in the current CF block.
+  * The resolver of the operand is drawn right away: constants and
+  * existing nodes are built directly, saving the Dummy, the temporary
+  * and the later exchange. Other resolvers need the operand as
+  * temporary, which keeps the drawn resolver for its resolution.
+  * Operands of nodes on the memory path must stay temporaries, since
+  * existing nodes may depend on the memory the node is inserted at.
+  **/
+static ir_node *new_operand(gen_context_t *ctx, ir_type *type) {
+    const kind_resolver_t *kind_resolver = get_kind_resolver(type);
+    int resolver = -1;
+
+    while (kind_resolver != NULL) {
+        resolver = draw_resolver(ctx, kind_resolver);
+        adopt_func_t func = kind_resolver->resolvers[resolver]->func;
+        ir_node *node = NULL;
+        if (func == adopt_const) {
+            node = new_random_const(ctx, get_type_mode(type));
+        } else if (func == adopt_existing) {
+            node = find_existing(ctx, type);
+        } else {
+            break;
+        }
+        if (node != NULL) {
+            // Counts towards the fill factor like a temporary would
+            ctx->cfb->n_nodes += 1;
+            reach_add_node(ctx->reach, ctx->cfb->index, node);
+            register_resolved(ctx, node, type);
+            return node;
+        }
+        // No existing node available, draw again like apply_kind_resolver()
+    }
+
+    ir_mode *mode = is_Primitive_type(type) ? get_type_mode(type) : mode_P;
+    ir_node *dummy = new_Dummy(mode);
+    temp_t *temp = add_temporary(ctx, ctx->cfb, dummy, type);
+    temp->resolver = resolver;
+    return dummy;
 }
 
 /**
   * Adopt function call as dummy replacement
   **/
-static ir_node *adopt_fcall(void) {
+static ir_node *adopt_fcall(gen_context_t *ctx) {
     // Are function calls disabled?
     if (fs_params.cfb.has_func_calls == false) {
         return NULL;
@@ -353,17 +543,17 @@ static ir_node *adopt_fcall(void) {
 
     // We currently do not support resolving compound temporaries
     // with function calls
-    if (is_compound_type(current_temp->type)) {
+    if (is_compound_type(ctx->temp->type)) {
         return NULL;
     }
 
     // Are we exceeding the maxium number of function calls?
-    int n_calls = ARR_LEN(current_func->calls);
+    int n_calls = ARR_LEN(ctx->func->calls);
     if (n_calls >= fs_params.func.max_calls) {
         return NULL;
     }
 
-    func_t *func = prog_get_random_func(current_prog);
+    func_t *func = prog_get_random_func(ctx->prog);
     // Is there even a function to call? We do not allow calling main()
     if (func == NULL) {
         return NULL;
@@ -371,7 +561,7 @@ static ir_node *adopt_fcall(void) {
 
     // If cycles are prohibited, check whether introducing a function call
     // would introduce a cycle 
-    if (!fs_params.prog.has_cycles && func_is_dominated(func, current_func)) {
+    if (!fs_params.prog.has_cycles && func_is_dominated(ctx, func, ctx->func)) {
         return NULL;
     }
 
@@ -384,12 +574,12 @@ static ir_node *adopt_fcall(void) {
     int n_res = get_method_n_ress(proto);
     assert(n_res == 1);
     ir_type *ret_type = get_method_res_type(proto, 0);
-    if (ret_type != current_temp->type) {
+    if (ret_type != ctx->temp->type) {
         return NULL;
     }
 
     // Now all good, do function call
-    func_add_call(current_func, func);
+    func_add_call(ctx->func, func);
 
     int n_params = get_method_n_params(proto);
     ir_node *params[n_params];
@@ -397,7 +587,7 @@ static ir_node *adopt_fcall(void) {
     for (int i = 0; i < n_params; ++i) {
         param_type = get_method_param_type(proto, i);
         params[i]  = new_Dummy(get_type_mode(param_type));
-        cfb_add_temporary(current_cfb, params[i], param_type);
+        add_temporary(ctx, ctx->cfb, params[i], param_type);
     }
 
     ir_node *mem_dummy = new_Dummy(mode_M);
@@ -406,8 +596,7 @@ static ir_node *adopt_fcall(void) {
         func->n_params, params, proto
     );
 	ir_node *call_mem = new_Proj(call, mode_M, pn_Call_M);
-    exchange(current_cfb->mem, call_mem);
-    current_cfb->mem = mem_dummy;
+    update_memory(ctx, mem_dummy, call_mem);
 	ir_node *tuple  = new_Proj(call, mode_T, pn_Call_T_result);
 	ir_node *result = new_Proj(tuple, get_type_mode(ret_type), 0);
     return result;
@@ -417,156 +606,126 @@ static ir_node *adopt_fcall(void) {
   * Return random relation for Cmp node
   * @return Compare relation
   **/
-static ir_relation get_random_relation(void) {
-    return rand() % (ir_relation_greater_equal - ir_relation_false - 1) + 1;
+static ir_relation get_random_relation(gen_context_t *ctx) {
+    return rng_below(get_ctx_stream(ctx, STREAM_DATA), ir_relation_greater_equal - ir_relation_false - 1) + 1;
 }
 
 /**
   * Return compare node
   * @return Node to replace dummy
   **/
-static ir_node* adopt_cmp(void) {
-    assert(is_Primitive_type(current_temp->type));
-    assert(get_type_mode(current_temp->type) == mode_b);
+static ir_node* adopt_cmp(gen_context_t *ctx) {
+    assert(is_Primitive_type(ctx->temp->type));
+    assert(get_type_mode(ctx->temp->type) == mode_b);
     ir_type* type   = get_int_type();
-    ir_mode* mode   = get_type_mode(type);
-    ir_node* dummy1 = new_Dummy(mode);
-    ir_node* dummy2 = new_Dummy(mode);
-    ir_node* cmp    = new_r_Cmp(current_cfb->irb, dummy1, dummy2, get_random_relation());
-    cfb_add_temporary(current_cfb, dummy1, type);
-    cfb_add_temporary(current_cfb, dummy2, type);
+    ir_node* left   = new_operand(ctx, type);
+    ir_node* right  = new_operand(ctx, type);
+    ir_node* cmp    = new_r_Cmp(ctx->cfb->irb, left, right, get_random_relation(ctx));
     return cmp;
 }
 
 /**
   * Add a store node to the current CF block.
   **/
-static void seed_store(ir_node *node) {
-    if (is_dominated(node, current_cfb->mem)) {
+static void seed_store(gen_context_t *ctx, ir_node *node, ir_type *type) {
+    if (is_dominated(ctx, node, ctx->cfb->mem)) {
         // Consuming given node in a Store,
         // would result in loop in memory path
         return;
     }
 
     // TODO: Allow to store pointers to compounds
-    if (is_Primitive_type(current_temp->type) && get_type_mode(current_temp->type) == mode_b) {
+    if (is_Primitive_type(type) && get_type_mode(type) == mode_b) {
         return;
     }
 
-    ir_type *ref_type  = new_type_pointer(current_temp->type);
+    ir_type *ref_type  = get_pointer_type_to(type);
     ir_node *dummy_ptr = new_Dummy(mode_P);
-    cfb_add_temporary(current_cfb, dummy_ptr, ref_type);
+    add_temporary(ctx, ctx->cfb, dummy_ptr, ref_type);
 
     ir_node *mem_dummy = new_Dummy(mode_M);
     ir_node *store     = new_r_Store(
-        current_cfb->irb, mem_dummy, dummy_ptr,
-        node, current_temp->type, cons_none);
+        ctx->cfb->irb, mem_dummy, dummy_ptr,
+        node, type, cons_none);
 	ir_node *store_mem = new_Proj(store, mode_M, pn_Store_M);
-    update_memory(mem_dummy, store_mem);
+    update_memory(ctx, mem_dummy, store_mem);
 
-    if (is_Pointer_type(current_temp->type)) {
+    if (is_Pointer_type(type)) {
         //printf("Storing pointer: %ld\n", get_irn_node_nr(store));
     }
 
 }
 
+/**
+  * Draws resolvers of the kind until one of them can be applied.
+  * @param resolver Resolver drawn when the temporary was created, -1 if none
+  * @return Node to replace the current temporary
+  **/
+static ir_node *apply_kind_resolver(gen_context_t *ctx, const kind_resolver_t *kind_resolver, int resolver) {
+    ir_node *new_node = NULL;
+    if (resolver >= 0) {
+        new_node = kind_resolver->resolvers[resolver]->func(ctx);
+    }
+    while (new_node == NULL) {
+        // A declining resolver only costs another draw
+        new_node = kind_resolver->resolvers[draw_resolver(ctx, kind_resolver)]->func(ctx);
+    }
+    assert(get_irn_opcode(new_node) != iro_Dummy);
+    return new_node;
+}
+
 /**
   * Resolve temporary using different techniques depending on the associated
   * type.
   * @param temporary The temporary to be resolved
   **/
-static void resolve_temp(temp_t *temporary) {
-    current_temp = temporary;
+static void resolve_temp(gen_context_t *ctx, temp_t *temporary) {
+    ctx->temp = temporary;
 
     // We try different techniques for resolving temporaries.
     // If the chosen method cannot be applied, we randomly
     // choose methods until one, which can be applied is found.
     ir_node *new_node = NULL;
     ir_type *type = temporary->type;
+    const kind_resolver_t *kind_resolver = get_kind_resolver(type);
 
-    kind_resolver_t *kind_resolver;
-    if (is_Primitive_type(type)) {
-        if (get_type_mode(type) == mode_b) {
-            new_node = adopt_cmp();
-            goto replace;
-        } else {
-            kind_resolver = kind_resolver_arr[1];
-        }
+    if (kind_resolver == NULL) {
+        new_node = adopt_cmp(ctx);
     } else {
-        kind_resolver = kind_resolver_arr[0];
+        new_node = apply_kind_resolver(ctx, kind_resolver, temporary->resolver);
     }
 
-    update_ips_table(kind_resolver);
-
-    while (new_node == NULL) {
-        double random = get_random_percentage();
-        int resolved = 0;
-        //for (int i = 0; i < 6; ++i ) printf("%f\t", interpolation_prefix_sum[i]);
-        for (int i = 0; i < kind_resolver->n_resolvers && !resolved; ++i) {
-            //printf("%d : %f >? %f\n", i, kind_resolver->ips_table[i], random);
-            if (kind_resolver->ips_table[i] > random) {
-                new_node = kind_resolver->resolvers[i]->func();
-                if (new_node != NULL) assert(get_irn_opcode(new_node) != iro_Dummy);
-                //printf("New node %ld\n", get_irn_node_nr(new_node));
-                resolved = 1;
-            }
-        }
-        assert(resolved);
-    }
-replace:
     assert(get_irn_opcode(new_node) != iro_Dummy);
-    exchange(temporary->node, new_node);
+    exchange_node(ctx, temporary->node, new_node);
     assert(get_irn_opcode(new_node) != iro_Dummy);
     temporary->node = new_node;
-    stats_register_op(get_irn_opcode(new_node));
-
     temporary->resolved = 1;
-
-    if (rand() % 8 == 1) {
-        seed_store(new_node);
-    }
+    register_resolved(ctx, new_node, type);
 }
 
 /**
-  * Resolve temporaries inside CF block.
-  * @param cfb CF block
-  **/ 
-static void resolve_cfb(cfb_t *cfb) {
-    // If we have a loop, we might already have visited this CF block,
-    // but as long as we have temporaries to resolve, we need to
-    // process it. Newly added unresolved temporaries originate from
-    // loops in the CF.
-    // Even though there might be temporaries, we cannot already abort
-    // before having invoked the resolution of tempoaries in predecessor
-    // block, since blocks with only one successor have initially no
-    // temporaries at all.
-resolve_cfb_start:
-    if (cfb->n_temporaries == 0 && cfb->visited >= get_visit_counter()) {
-        return;
-    }
-
-    // Mark as visited
-    cfb->visited = get_visit_counter();
-
-    // Start context for cfb
-    current_cfb = cfb;
-    set_cur_block(cfb->irb);
-
-    // Resolve all temporaries
-    cfb_for_each_temp(cfb, temp) {
-        if (!temp->resolved) {
-            resolve_temp(temp);
+  * Resolve the temporaries of the CF blocks on the worklist.
+  * Resolving a temporary may add new ones, either to the same
+  * block (they are appended to its queue and handled in the same
+  * round) or to predecessors (which are queued in turn), so every
+  * temporary is visited exactly once.
+  **/
+static void resolve_worklist(gen_context_t *ctx) {
+    while (!pdeq_empty(ctx->worklist)) {
+        cfb_t *cfb = pdeq_getl(ctx->worklist);
+
+        // Start context for cfb
+        ctx->cfb = cfb;
+        set_cur_block(cfb->irb);
+
+        while (!list_empty(&cfb->unresolved)) {
+            temp_t *temp = list_entry(cfb->unresolved.next, temp_t, queue);
+            list_del(&temp->queue);
+            resolve_temp(ctx, temp);
             cfb->n_temporaries -= 1;
         }
+        cfb->queued = 0;
     }
-
-    // Visit all predecessor CF blocks
-    cfb_for_each_predecessor(cfb, pred_it) {
-        cfb_t *pred = cfb_get_predecessor(cfb, pred_it);
-        resolve_cfb(pred);
-    }
-
-    goto resolve_cfb_start;
 }
 
 /**
@@ -579,12 +738,12 @@ resolve_cfb_start:
   *
   * @param cfg CF graph
   **/
-static void resolve_cfg(cfg_t *cfg) {
-    current_cfg = cfg;
+static void resolve_cfg(gen_context_t *ctx, cfg_t *cfg) {
+    ctx->cfg = cfg;
 
-    ir_entity *entity = get_irg_entity(current_func->irg);
+    ir_entity *entity = get_irg_entity(ctx->func->irg);
     ir_type *proto    = get_entity_type(entity);
-    ir_node *args     = get_irg_args(current_func->irg);
+    ir_node *args     = get_irg_args(ctx->func->irg);
 
     // TODO: Add support for compound function parameters 
 
@@ -598,37 +757,84 @@ static void resolve_cfg(cfg_t *cfg) {
         ir_mode *mode = get_type_mode(type);
         ir_node *proj = new_Proj(args, mode, i);
         // Add resolved temporary
-        temp_t *temp  = new_temporary(proj, type);
+        temp_t *temp  = new_temporary(start->obst, proj, type);
         temp->resolved = 1;
         list_add_tail(&temp->head, &start->temporaries);
+        add_resolved(ctx, start, proj, type);
     }
 
     // Start resolving the temporaries by starting at the blocks with
-    // no successors and push the unresolved temporaries upwards inside the graph
+    // no successors, followed by the other blocks holding temporaries
+    // from the conversion. Unresolved temporaries pushed upwards inside
+    // the graph queue their blocks again.
     for (int i = 0; i < cfg->n_blocks; ++i) {
         cfb_t *cfb = cfg->blocks[i];
-        if (cfb->n_successors == 0) {
-            inc_visit_counter();
-            resolve_cfb(cfb);
+        if (cfb->n_successors == 0 && !list_empty(&cfb->unresolved)) {
+            enqueue_cfb(ctx, cfb);
+        }
+    }
+    for (int i = 0; i < cfg->n_blocks; ++i) {
+        cfb_t *cfb = cfg->blocks[i];
+        if (!list_empty(&cfb->unresolved)) {
+            enqueue_cfb(ctx, cfb);
         }
     }
+    resolve_worklist(ctx);
 }
 
 /**
   * Resolve the temporaries inside the provided function
   * @param func Function
   **/
-static void resolve_func(func_t *func) {
-    current_func = func;
+static void resolve_func(gen_context_t *ctx, func_t *func) {
+    ctx->func = func;
     set_current_ir_graph(func->irg);
-    resolve_cfg(func->cfg);
+
+    // Register the temporaries and memory dummies created by the conversion
+    cfg_t *cfg = func->cfg;
+    ctx->reach    = new_reach(cfg->n_blocks);
+    ctx->resolved = calloc(cfg->n_blocks, sizeof(cpmap_t*));
+    ctx->worklist = new_pdeq();
+    for (int i = 0; i < cfg->n_blocks; ++i) {
+        cfb_t *cfb = cfg->blocks[i];
+        if (cfb->mem != NULL) {
+            reach_add_node(ctx->reach, cfb->index, cfb->mem);
+        }
+        cfb_for_each_temp(cfb, temp) {
+            reach_add_node(ctx->reach, cfb->index, temp->node);
+        }
+    }
+
+    resolve_cfg(ctx, cfg);
+
+    del_pdeq(ctx->worklist);
+    ctx->worklist = NULL;
+    free_reach(ctx->reach);
+    ctx->reach = NULL;
+    for (int i = 0; i < cfg->n_blocks; ++i) {
+        cpmap_t *resolved = ctx->resolved[i];
+        if (resolved == NULL) {
+            continue;
+        }
+        cpmap_iterator_t it;
+        cpmap_iterator_init(&it, resolved);
+        for (cpmap_entry_t entry = cpmap_iterator_next(&it); entry.key != NULL;
+             entry = cpmap_iterator_next(&it)) {
+            DEL_ARR_F(entry.data);
+        }
+        cpmap_destroy(resolved);
+        free(resolved);
+    }
+    free(ctx->resolved);
+    ctx->resolved = NULL;
 }
 
 /**
   * Walker for resolve_mem_graph()
   * @param cfb CF block currently walked over
   **/ 
-static void resolve_mem_graph_walker_post(cfb_t *cfb) {
+static void resolve_mem_graph_walker_post(cfb_t *cfb, void *env) {
+    (void)env;
     if (cfb->last_mem == NULL) return;
     set_cur_block(cfb->irb);
     ir_node *store = get_store();
@@ -649,12 +855,12 @@ static void resolve_mem_graph_walker_post(cfb_t *cfb) {
   * in order to trigger the resolution of memory dependencies.
   * @param cfg CF graph with memory to be resolved
   **/
-static void resolve_mem_graph(cfg_t *cfg) {
+static void resolve_mem_graph(gen_context_t *ctx, cfg_t *cfg) {
     //edges_activate(get_current_ir_graph());
     for (int i = 0; i < cfg->n_blocks; ++i) {
         cfb_t *cfb = cfg->blocks[i];
         if (cfb->n_successors == 0) {
-            cfb_walk_predecessors(cfb, NULL, resolve_mem_graph_walker_post, NULL);
+            cfb_walk_predecessors(ctx, cfb, NULL, resolve_mem_graph_walker_post, NULL, NULL);
         }
     }
 }
@@ -664,10 +870,11 @@ static void resolve_mem_graph(cfg_t *cfg) {
   * @param prog Program to be resolved
   **/
 void resolve_prog(prog_t *prog) {
-    current_prog = prog;
+    gen_context_t *ctx = prog->ctx;
+    ctx->prog = prog;
     for (size_t i = 0; i < ARR_LEN(prog->funcs); ++i) {
-        resolve_func(prog->funcs[i]);
-        resolve_mem_graph(prog->funcs[i]->cfg);
+        resolve_func(ctx, prog->funcs[i]);
+        resolve_mem_graph(ctx, prog->funcs[i]->cfg);
     }
     //print_func_call_graph(prog->funcs[0]);
 }
@@ -685,6 +892,7 @@ void initialize_resolve(void) {
     pointer_resolver->resolvers[i++] = new_resolver(adopt_member,   40, 40);
     pointer_resolver->resolvers[i++] = new_resolver(adopt_existing, 99, 99);
     assert(i == pointer_resolver->n_resolvers);
+    init_alias_tables(pointer_resolver);
 
     // Create resolver for primitive
     kind_resolver_t *prim_resolver = new_kind_resolver(7);
@@ -698,6 +906,7 @@ void initialize_resolve(void) {
     prim_resolver->resolvers[i++] = new_resolver(adopt_conv,     p, p);
     prim_resolver->resolvers[i++] = new_resolver(adopt_fcall,    100, 100);
     assert(i == prim_resolver->n_resolvers);
+    init_alias_tables(prim_resolver);
 
     n_kind_resolver = 2;
     kind_resolver_arr = calloc(n_kind_resolver, sizeof(kind_resolver_t*));
@@ -709,5 +918,73 @@ void initialize_resolve(void) {
   * Clean up data allocated by resolve module
   **/
 void finish_resolve(void) {
-    // TODO: clean up
+    for (int i = 0; i < n_kind_resolver; ++i) {
+        kind_resolver_t *kind_resolver = kind_resolver_arr[i];
+        for (int j = 0; j < kind_resolver->n_resolvers; ++j) {
+            free(kind_resolver->resolvers[j]);
+        }
+        for (int level = 0; level <= N_FILL_LEVELS; ++level) {
+            free(kind_resolver->tables[level].threshold);
+            free(kind_resolver->tables[level].alias);
+        }
+        free(kind_resolver->resolvers);
+        free(kind_resolver);
+    }
+    free(kind_resolver_arr);
+    kind_resolver_arr = NULL;
+    n_kind_resolver   = 0;
+}
+
+// Every adopt function in a fixed order, so that the fingerprint can
+// identify the resolvers without depending on their addresses
+static const adopt_func_t known_adopt_funcs[] = {
+    adopt_phi,
+    adopt_alloc,
+    adopt_member,
+    adopt_existing,
+    adopt_const,
+    adopt_operator,
+    adopt_load,
+    adopt_conv,
+    adopt_fcall
+};
+
+static uint64_t get_adopt_func_index(adopt_func_t func) {
+    size_t n = sizeof(known_adopt_funcs) / sizeof(known_adopt_funcs[0]);
+    for (size_t i = 0; i < n; ++i) {
+        if (known_adopt_funcs[i] == func) {
+            return i;
+        }
+    }
+    assert(false && "adopt function missing in known_adopt_funcs");
+    return UINT64_MAX;
+}
+
+/**
+  * Fingerprint of the resolver tables set up by initialize_resolve(),
+  * which changes if the resolvers are drawn differently.
+  **/
+uint64_t resolve_fingerprint(void) {
+    uint64_t fp = FINGERPRINT_INIT;
+    fp = fingerprint_add(fp, n_kind_resolver);
+    fp = fingerprint_add(fp, N_FILL_LEVELS);
+    for (int i = 0; i < n_kind_resolver; ++i) {
+        const kind_resolver_t *kind_resolver = kind_resolver_arr[i];
+        int n = kind_resolver->n_resolvers;
+        fp = fingerprint_add(fp, n);
+        for (int j = 0; j < n; ++j) {
+            const resolver_t *resolver = kind_resolver->resolvers[j];
+            fp = fingerprint_add(fp, get_adopt_func_index(resolver->func));
+            fp = fingerprint_add_double(fp, resolver->prob.start);
+            fp = fingerprint_add_double(fp, resolver->prob.end);
+        }
+        for (int level = 0; level <= N_FILL_LEVELS; ++level) {
+            const alias_table_t *table = &kind_resolver->tables[level];
+            for (int j = 0; j < n; ++j) {
+                fp = fingerprint_add(fp, table->threshold[j]);
+                fp = fingerprint_add(fp, (uint64_t)table->alias[j]);
+            }
+        }
+    }
+    return fp;
 }
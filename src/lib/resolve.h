@@ -1,11 +1,14 @@
 #ifndef RESOLVE_H
 #define RESOLVE_H
 
+#include <stdint.h>
+
 #include "cfg.h"
 #include "prog.h"
 
 void initialize_resolve(void);
 void finish_resolve(void);
+uint64_t resolve_fingerprint(void);
 
 void resolve_prog(prog_t *prog);
 
@@ -18,36 +18,33 @@ void print_cfg_stats(cfg_t *cfg) {
     printf("\n");
 }
 
-unsigned opcodes[iro_last] = {0};
-
-static void op_stats_init(void) {
+static void op_stats_init(gen_context_t *ctx) {
     for (int i = 0; i < iro_last; ++i) {
-        opcodes[i] = 0;
+        ctx->opcodes[i] = 0;
     }
 }
 
 static void op_stats_walker(ir_node *node, void *data) {
     ;//printf("Visiting %s\n", get_op_name(get_irn_op(node)));
-    (void)data;
-    opcodes[get_irn_opcode(node)] += 1;
+    gen_context_t *ctx = data;
+    ctx->opcodes[get_irn_opcode(node)] += 1;
 }
 
-void print_op_stats(cfg_t *cfg) {
-    (void)cfg;
-    //op_stats_init();
+void print_op_stats(gen_context_t *ctx) {
+    //op_stats_init(ctx);
     //ir_graph *irg = get_current_ir_graph();
-    //irg_walk_graph(irg, op_stats_walker, NULL, NULL);
+    //irg_walk_graph(irg, op_stats_walker, NULL, ctx);
     ;//printf("IR operation statistics\n");
     ;//printf("========================\n");
     for (int i = 0; i < iro_last; ++i) {
-        if (opcodes[i] != 0) {
+        if (ctx->opcodes[i] != 0) {
             //ir_op* op = ir_get_opcode(i);
-            ;//printf("%s: %d\n", get_op_name(op), opcodes[i]);
+            ;//printf("%s: %d\n", get_op_name(op), ctx->opcodes[i]);
         }
     }
     ;//printf("\n");
 }
 
-void stats_register_op(unsigned iro) {
-    opcodes[iro] += 1;
+void stats_register_op(gen_context_t *ctx, unsigned iro) {
+    ctx->opcodes[iro] += 1;
 }
@@ -4,6 +4,6 @@
 #include "cfg.h"
 
 void print_cfg_stats(cfg_t *cfg);
-void print_op_stats(cfg_t *cfg);
-void stats_register_op(unsigned iro);
+void print_op_stats(gen_context_t *ctx);
+void stats_register_op(gen_context_t *ctx, unsigned iro);
 #endif
@@ -1,5 +1,13 @@
 #include "types.h"
 #include <libfirm/adt/array.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../adt/cpmap.h"
+#include "../adt/hashptr.h"
+#include "fingerprint.h"
 
 int n_modes;
 static ir_mode **modes = NULL;
@@ -7,10 +15,27 @@ static ir_mode **modes = NULL;
 int n_primitives;
 static ir_type **primitive_types = NULL;
 static ir_type **compound_types  = NULL;
-static ir_entity **entities      = NULL;
+// Member entities by their type, each mapped to an array of entities
+static cpmap_t entities_by_type;
+// Interned pointer types by the type pointed to
+static cpmap_t pointer_types;
 
 static void print_type(ir_type *type);
 
+// Number of idents created for the current program
+static unsigned n_type_ids = 0;
+
+/**
+  * Returns a new ident for a type or entity.
+  * Unlike id_unique() the numbering restarts with every program,
+  * so that the names only depend on the seed.
+  **/
+static ident *new_type_id(const char *tag) {
+    char name[32];
+    snprintf(name, sizeof(name), "%s.%u", tag, n_type_ids++);
+    return new_id_from_str(name);
+}
+
 static void create_modes(void) {
     n_modes = 10;
     modes = calloc(n_modes, sizeof(ir_mode*));
@@ -42,34 +67,47 @@ static void create_primitive_types(void) {
     }
 }
 
+static unsigned hash_type(const void *type) {
+    return hash_ptr(type);
+}
+
+static int types_equal(const void *type1, const void *type2) {
+    return type1 == type2;
+}
+
 static ir_entity *get_registered_entity(ir_type *owner, ir_type *type) {
-    ir_entity* ent = new_entity(owner, id_unique("fs_entity"), type);
+    ir_entity* ent = new_entity(owner, new_type_id("fs_entity"), type);
+    ir_entity **entities = cpmap_find(&entities_by_type, type);
+    if (entities == NULL) {
+        entities = NEW_ARR_F(ir_entity*, 0);
+    }
     ARR_APP1(ir_entity*, entities, ent);
+    cpmap_set(&entities_by_type, type, entities);
     return ent;
 }
 
 static ir_type *get_registered_struct(void) {
-    ir_type *type = new_type_struct(id_unique("fs_struct"));
+    ir_type *type = new_type_struct(new_type_id("fs_struct"));
     ARR_APP1(ir_type*, compound_types, type);
     return type;
 }
 
-static void create_struct_type(void) {
+static void create_struct_type(rng_t *rng) {
     ir_type *type = get_registered_struct();
     int offset = 0;
-    int n_members = 3 + rand() % 5;
+    int n_members = 3 + rng_below(rng, 5);
     for (int i = 0; i < n_members; ++i) {
-        int r = rand() % 4;
+        int r = rng_below(rng, 4);
         if (r == 0 && ARR_LEN(compound_types) > 1) {
             // 25% chance to pick compound entity
-            int compound_idx = compound_idx = rand() % (ARR_LEN(compound_types) - 1);
+            int compound_idx = rng_below(rng, ARR_LEN(compound_types) - 1);
             ir_type *member_type = compound_types[compound_idx];
             ir_entity *member_ent = get_registered_entity(type, member_type);
             set_entity_offset(member_ent, offset);
             offset += get_type_size(member_type);
         } else {
             // 75% change to primitive
-            ir_type *member_type  = get_random_prim_type();
+            ir_type *member_type  = get_random_prim_type(rng);
             ir_entity *member_ent = get_registered_entity(type, member_type);
             set_entity_offset(member_ent, offset);
             offset += get_mode_size_bytes(get_type_mode(member_type));
@@ -80,20 +118,20 @@ static void create_struct_type(void) {
 }
 
 static ir_type *get_registered_union(void) {
-    ir_type *type = new_type_union(id_unique("fs_union"));
+    ir_type *type = new_type_union(new_type_id("fs_union"));
     ARR_APP1(ir_type*, compound_types, type);
     return type;
 }
 
-static void create_union_type(void) {
+static void create_union_type(rng_t *rng) {
     ir_type *type = get_registered_union();
     int max_size = 0;
-    int n_members = 3 + rand() % 5;
+    int n_members = 3 + rng_below(rng, 5);
     for (int i = 0; i < n_members; ++i) {
-        int r = rand() % 4;
+        int r = rng_below(rng, 4);
         if (r == 0 && ARR_LEN(compound_types) > 1) {
             // 25% chance to pick compound entity
-            int compound_idx = compound_idx = rand() % (ARR_LEN(compound_types) - 1);
+            int compound_idx = rng_below(rng, ARR_LEN(compound_types) - 1);
             ir_type *member_type = compound_types[compound_idx];
             ir_entity *member_ent = get_registered_entity(type, member_type);
             set_entity_offset(member_ent, 0);
@@ -103,7 +141,7 @@ static void create_union_type(void) {
             }
         } else {
             // 75% change to primitive
-            ir_type *member_type  = get_random_prim_type();
+            ir_type *member_type  = get_random_prim_type(rng);
             ir_entity *member_ent = get_registered_entity(type, member_type);
             set_entity_offset(member_ent, 0);
             int member_size = get_mode_size_bytes(get_type_mode(member_type));
@@ -118,19 +156,19 @@ static void create_union_type(void) {
 
 
 ir_type* get_pointer_type(void) {
-    return primitive_types[0];
+    return primitive_types[1];
 }
 
 ir_type* get_bool_type(void) {
-    return primitive_types[1];
+    return primitive_types[0];
 }
 
 ir_type* get_int_type(void) {
     return primitive_types[2];
 }
 
-ir_type *get_random_prim_type(void) {
-    return primitive_types[rand() % (n_primitives - 2) + 2];
+ir_type *get_random_prim_type(rng_t *rng) {
+    return primitive_types[rng_below(rng, n_primitives - 2) + 2];
 }
 
 static void print_type_core(ir_type *type, int indent) {
@@ -162,30 +200,60 @@ static void print_type(ir_type *type) {
     printf("\n");
 }
 
-ir_entity *get_associated_entity(ir_type *type) {
-    // TODO: randomize picked entity if more candidates
-    for (size_t i = 0; i < ARR_LEN(entities); ++i) {
-        ir_entity *ent = entities[i];
-        if (get_entity_type(ent) == type) {
-            return ent;
+/**
+  * Returns the primitive type of the mode, which must be one of the
+  * modes of the type universe.
+  **/
+ir_type *get_prim_type(ir_mode *mode) {
+    for (int i = 0; i < n_primitives; ++i) {
+        if (modes[i] == mode) {
+            return primitive_types[i];
         }
     }
+    assert(false && "mode outside of the type universe");
     return NULL;
 }
 
+/**
+  * Returns the pointer type to the given type, creating it only
+  * on the first request, so that equal pointer types are identical.
+  **/
+ir_type *get_pointer_type_to(ir_type *points_to) {
+    ir_type *type = cpmap_find(&pointer_types, points_to);
+    if (type == NULL) {
+        type = new_type_pointer(points_to);
+        cpmap_set(&pointer_types, points_to, type);
+    }
+    return type;
+}
+
+/**
+  * Returns a random member entity of the given type
+  * or NULL if no compound type has such a member.
+  **/
+ir_entity *get_associated_entity(rng_t *rng, ir_type *type) {
+    ir_entity **entities = cpmap_find(&entities_by_type, type);
+    if (entities == NULL) {
+        return NULL;
+    }
+    return entities[rng_below(rng, ARR_LEN(entities))];
+}
+
 /**
   * Initialize types module
   **/
-void initialize_types(void) {
+void initialize_types(rng_t *rng) {
+    n_type_ids = 0;
     create_modes();
     create_primitive_types();
-    entities = NEW_ARR_F(ir_entity*, 0);
+    cpmap_init(&entities_by_type, hash_type, types_equal);
+    cpmap_init(&pointer_types, hash_type, types_equal);
     compound_types = NEW_ARR_F(ir_type*, 0);
     for (int i = 0; i < 10; ++i) {
-        if (rand() % 2 == 0) {
-            create_union_type();
+        if (rng_below(rng, 2) == 0) {
+            create_union_type(rng);
         } else {
-            create_struct_type();
+            create_struct_type(rng);
         }
     }
 }
@@ -195,5 +263,62 @@ void initialize_types(void) {
   * Clean up data allocated by types module
   **/
 void finish_types(void) {
+    // The types and entities themselves are owned by the irp
+    cpmap_iterator_t it;
+    cpmap_iterator_init(&it, &entities_by_type);
+    for (cpmap_entry_t entry = cpmap_iterator_next(&it); entry.key != NULL;
+         entry = cpmap_iterator_next(&it)) {
+        DEL_ARR_F(entry.data);
+    }
+    cpmap_destroy(&entities_by_type);
+    cpmap_destroy(&pointer_types);
+    DEL_ARR_F(compound_types);
+    free(primitive_types);
+    free(modes);
+    compound_types  = NULL;
+    primitive_types = NULL;
+    modes           = NULL;
+}
+
+/**
+  * Returns the index of a type of the universe, primitive types first
+  **/
+static uint64_t get_universe_index(ir_type *type) {
+    for (int i = 0; i < n_primitives; ++i) {
+        if (primitive_types[i] == type) {
+            return i;
+        }
+    }
+    for (size_t i = 0; i < ARR_LEN(compound_types); ++i) {
+        if (compound_types[i] == type) {
+            return n_primitives + i;
+        }
+    }
+    assert(false && "type outside of the type universe");
+    return UINT64_MAX;
+}
 
+/**
+  * Fingerprint of the type universe built by initialize_types(),
+  * which changes if the same stream builds other types.
+  **/
+uint64_t types_fingerprint(void) {
+    uint64_t fp = FINGERPRINT_INIT;
+    fp = fingerprint_add(fp, n_modes);
+    for (int i = 0; i < n_modes; ++i) {
+        fp = fingerprint_add_str(fp, get_mode_name(modes[i]));
+    }
+    fp = fingerprint_add(fp, ARR_LEN(compound_types));
+    for (size_t i = 0; i < ARR_LEN(compound_types); ++i) {
+        ir_type *type = compound_types[i];
+        fp = fingerprint_add(fp, is_Struct_type(type));
+        fp = fingerprint_add(fp, get_type_size(type));
+        fp = fingerprint_add(fp, get_compound_n_members(type));
+        for (size_t m = 0; m < get_compound_n_members(type); ++m) {
+            ir_entity *member = get_compound_member(type, m);
+            fp = fingerprint_add(fp, get_universe_index(get_entity_type(member)));
+            fp = fingerprint_add(fp, (uint64_t)get_entity_offset(member));
+        }
+    }
+    return fp;
 }
@@ -2,14 +2,20 @@
 #define TYPES_H
 
 #include <libfirm/firm.h>
+#include <stdint.h>
 
-void initialize_types(void);
+#include "random.h"
+
+void initialize_types(rng_t *rng);
 void finish_types(void);
 
 ir_type* get_pointer_type(void);
 ir_type* get_bool_type(void);
 ir_type *get_int_type(void);
-ir_type *get_random_prim_type(void);
-ir_entity *get_associated_entity(ir_type *type);
+ir_type *get_prim_type(ir_mode *mode);
+ir_type *get_pointer_type_to(ir_type *points_to);
+ir_type *get_random_prim_type(rng_t *rng);
+ir_entity *get_associated_entity(rng_t *rng, ir_type *type);
+uint64_t types_fingerprint(void);
 
 #endif
@@ -1,3 +1,7 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
 #include <sys/time.h>
 #include <time.h>
 
@@ -5,8 +9,16 @@
 #include "lib/resolve.h"
 #include "lib/types.h"
 #include "lib/convert.h"
+#include "lib/context.h"
+#include "lib/corpus.h"
+#include "lib/optimizations.h"
+#include "cmdline/actions.h"
 #include "cmdline/options.h"
 #include "cmdline/help.h"
+#include "cmdline/irout.h"
+#include "cmdline/server.h"
+#include "cmdline/fanout.h"
+#include "cmdline/sweep.h"
 
 #define LINK_COMMAND          "grep -vE '(\\.type|\\.size)' a.s > a.S && cc -m32 a.S"
 
@@ -23,17 +35,46 @@ static void initialize_firmsmith(void) {
 	set_optimize(0);
 	//machine_triple_t *machine = firm_get_host_machine();
 	//setup_firm_for_machine(machine);
-	initialize_types();
 	initialize_resolve();
 }
 
 static void finish_firmsmith(void) {
 	finish_resolve();
-	finish_types();
 	ir_finish();
 	//gen_firm_finish();
 }
 
+/**
+ * Sets up the per-program state: creates a generator context seeded with
+ * the current seed and the type universe inside the current irp.
+ */
+static gen_context_t *initialize_prog(void) {
+	gen_context_t *ctx = new_gen_context((uint32_t)fs_params.prog.seed);
+	initialize_types(get_ctx_stream(ctx, STREAM_TYPES));
+	return ctx;
+}
+
+/**
+ * Replaces the current irp by an empty one.
+ */
+static void reset_irp(void) {
+	ir_prog *fresh_irp = new_ir_prog("firmsmith");
+	free_ir_prog();
+	set_irp(fresh_irp);
+}
+
+/**
+ * Drops the per-program state, so that the next program starts with an
+ * empty irp. libFirm itself and the resolvers stay initialized.
+ */
+static void finish_prog(prog_t *prog) {
+	gen_context_t *ctx = prog->ctx;
+	destroy_prog(prog);
+	free_gen_context(ctx);
+	finish_types();
+	reset_irp();
+}
+
 static void verify_no_dummy(ir_node *node, void *env) {
 	(void)env;
 	if (get_irn_opcode(node) == iro_Dummy) {
@@ -43,8 +84,31 @@ static void verify_no_dummy(ir_node *node, void *env) {
 	}
 }
 
+static void skip_id_inputs(ir_node *node, void *env) {
+	(void)env;
+	for (int i = 0, n = get_irn_arity(node); i < n; ++i) {
+		ir_node *pred = get_irn_n(node, i);
+		if (is_Id(pred)) {
+			set_irn_n(node, i, skip_Id(pred));
+		}
+	}
+}
+
+/**
+ * Drops the Id nodes left behind by exchanging the Dummy nodes and copies
+ * every graph without the nodes no longer reachable. No optimization is
+ * applied, the semantics of the graphs stay the same.
+ */
+static void compact_prog(void) {
+	for (size_t i = 0, n = get_irp_n_irgs(); i < n; ++i) {
+		ir_graph *irg = get_irp_irg(i);
+		irg_walk_graph(irg, skip_id_inputs, NULL, NULL);
+		dead_node_elimination(irg);
+	}
+}
+
 static void generate_main_func(void) {
-	ir_type *int_type = new_type_primitive(mode_Is);
+	ir_type *int_type = get_prim_type(mode_Is);
 	ir_type *type = new_type_method(0, 1, false, cc_cdecl_set, mtp_no_property);  // create the type
 	set_method_res_type(type, 0, int_type);                                       // set the result type
 	ir_entity *ent = new_entity(get_glob_type(), new_id_from_str("main"), type);
@@ -61,10 +125,46 @@ static void generate_main_func(void) {
 	irg_finalize_cons(fn_main);
 }
 
-static int action_run(const char *argv0) {
-	(void)argv0;
-	// Create random function
-	prog_t* prog = new_random_prog();
+/**
+ * Opens the destination of the per-pass measurements, if any.
+ * @return NULL if --pass-stats was not given or could not be opened,
+ *         the latter after printing the reason
+ */
+static FILE *open_pass_stats(void) {
+	const char *name = fs_params.run.pass_stats;
+	if (name == NULL) {
+		return NULL;
+	} else if (strcmp(name, "-") == 0) {
+		return stdout;
+	}
+	FILE *out = fopen(name, "a");
+	if (out == NULL) {
+		fprintf(stderr, "couldn't open %s for writing: %s\n", name, strerror(errno));
+	}
+	return out;
+}
+
+/**
+ * Appends the freshly generated program to the corpus given by --corpus-out.
+ */
+static void save_to_corpus(const prog_t *prog) {
+	const char *name = fs_params.run.corpus_out;
+	FILE *out = fopen(name, "ab");
+	if (out == NULL) {
+		fprintf(stderr, "couldn't open %s for writing: %s\n", name, strerror(errno));
+		return;
+	}
+	if (!corpus_write_prog(out, prog)) {
+		fprintf(stderr, "couldn't write to %s\n", name);
+	}
+	fclose(out);
+}
+
+/**
+ * Converts a generated program to verified libFirm graphs and adds a main
+ * function.
+ */
+static void lower_prog(prog_t *prog) {
 	// Construct corresponding ir node tree
 	convert_prog(prog);
 	//cfg_print(func->cfg);
@@ -76,23 +176,103 @@ static int action_run(const char *argv0) {
 	/* Just to make the linker happy, create 'main' */
 	generate_main_func();
 
+	for (size_t i = 0; i < ARR_LEN(prog->funcs); ++i) {
+		irg_walk_graph(prog->funcs[i]->irg, verify_no_dummy, NULL, NULL);
+	}
+
+	if (fs_params.run.compact) {
+		compact_prog();
+	}
+}
+
+/**
+ * Generates the program for the current parameters and lowers it.
+ */
+static prog_t *build_prog(void) {
+	gen_context_t *ctx = initialize_prog();
+	// Create random function
+	prog_t* prog = new_random_prog(ctx);
+	lower_prog(prog);
+	return prog;
+}
+
+/**
+ * Exports, dumps and tests the lowered program, then frees it.
+ */
+static int process_prog(prog_t *prog) {
+	// A campaign must not silently lose its measurements
+	FILE *stats_out = open_pass_stats();
+	if (fs_params.run.pass_stats != NULL && stats_out == NULL) {
+		finish_prog(prog);
+		return EXIT_FAILURE;
+	}
+
 	// Dump ir file
-	char ir_file_name[256];
-	snprintf(ir_file_name, sizeof ir_file_name, "%s.ir", fs_params.prog.strid);
-	FILE *irout = fopen(ir_file_name, "w");
+	char  ir_file_name[256];
+	FILE *irout = open_ir_out(fs_params.prog.strid, ir_file_name, sizeof ir_file_name);
+	if (irout == NULL) {
+		if (stats_out != NULL && stats_out != stdout) {
+			fclose(stats_out);
+		}
+		finish_prog(prog);
+		return EXIT_FAILURE;
+	}
 	ir_export_file(irout);
-	fclose(irout);
+	close_ir_out(irout);
 
-	dump_all_ir_graphs(fs_params.prog.strid);
+	// A streamed export cannot be read back, keep a copy to dump on failure
+	FILE *ir_copy = NULL;
+	if (fs_params.run.dump == DUMP_ON_FAILURE && ir_file_name[0] == '\0') {
+		ir_copy = tmpfile();
+		if (ir_copy != NULL) {
+			ir_export_file(ir_copy);
+		}
+	}
 
-	for (size_t i = 0; i < ARR_LEN(prog->funcs); ++i) {
-		irg_walk_graph(prog->funcs[i]->irg, verify_no_dummy, NULL, NULL);
+	if (fs_params.run.dump == DUMP_VCG) {
+		dump_all_ir_graphs(fs_params.prog.strid);
+	}
+
+	// A crash takes the process down before the dump below, so a crash
+	// names the command rebuilding it from the exported file instead
+	char crash_note[300];
+	bool has_crash_note = fs_params.run.dump == DUMP_ON_FAILURE && ir_file_name[0] != '\0';
+	if (has_crash_note) {
+		snprintf(crash_note, sizeof crash_note, "dump with: --dump-from-ir %s", ir_file_name);
+		set_opt_crash_note(crash_note);
+	}
+
+	int ret = EXIT_SUCCESS;
+	if (fs_params.run.passes != NULL) {
+		size_t *passes = parse_opt_list(fs_params.run.passes);
+		if (passes == NULL || !run_opt_pipeline(passes, stats_out)) {
+			ret = EXIT_FAILURE;
+		}
+		if (passes != NULL) {
+			DEL_ARR_F(passes);
+		}
+	}
+	if (has_crash_note) {
+		set_opt_crash_note(NULL);
+	}
+	if (fs_params.run.fan_out != NULL && ret == EXIT_SUCCESS) {
+		ret = fan_out_opts(fs_params.run.fan_out, stats_out);
+	}
+	if (stats_out != NULL && stats_out != stdout) {
+		fclose(stats_out);
+	}
+	if (ret != EXIT_SUCCESS && fs_params.run.dump == DUMP_ON_FAILURE) {
+		// The passes changed the graphs, dump them as exported instead
+		if (ir_copy != NULL) {
+			rewind(ir_copy);
+			dump_ir_stream(ir_copy, fs_params.prog.strid, fs_params.prog.strid);
+		} else if (ir_file_name[0] != '\0') {
+			dump_ir_file(ir_file_name, fs_params.prog.strid);
+		}
+	}
+	if (ir_copy != NULL) {
+		fclose(ir_copy);
 	}
-	
-	/*
-	(void)get_optimized_graph(get_current_ir_graph());
-	assert(irg_verify(get_current_ir_graph()) && "valid graph");
-	*/
 		/*
 
 	// Code generation
@@ -108,15 +288,209 @@ static int action_run(const char *argv0) {
 	// Stats
 	if (!nostats) {
 		print_cfg_stats(func->cfg);
-		print_op_stats(func->cfg);
+		print_op_stats(prog->ctx);
 	}
 
 	// finish libfirm
 	system(LINK_COMMAND);
 	*/
+	finish_prog(prog);
+	return ret;
+}
+
+/**
+ * Generates, records and processes the program for the current parameters.
+ * Only programs generated here go to the corpus, not the extra builds of
+ * --verify-determinism and --sweep.
+ */
+static int generate_prog(void) {
+	gen_context_t *ctx  = initialize_prog();
+	prog_t        *prog = new_random_prog(ctx);
+	if (fs_params.run.corpus_out != NULL) {
+		save_to_corpus(prog);
+	}
+	lower_prog(prog);
+	return process_prog(prog);
+}
+
+/**
+ * Rebuilds the program of the next corpus record, not yet lowered.
+ * @return NULL with status CORPUS_END, CORPUS_ERROR or CORPUS_STALE
+ *         if there is none
+ */
+static prog_t *load_corpus_prog(FILE *in, corpus_status_t *status) {
+	*status = corpus_read_params(in);
+	if (*status != CORPUS_OK) {
+		return NULL;
+	}
+	gen_context_t *ctx  = initialize_prog();
+	prog_t        *prog = corpus_read_prog(in, ctx, status);
+	if (prog == NULL) {
+		free_gen_context(ctx);
+		finish_types();
+	}
+	return prog;
+}
+
+/**
+ * Rebuilds the programs of the corpus given by --corpus-in and processes
+ * them like generated ones, program i being named <strid>-<i>.
+ */
+static int run_corpus(void) {
+	const char *name = fs_params.run.corpus_in;
+	FILE *in = fopen(name, "rb");
+	if (in == NULL) {
+		fprintf(stderr, "couldn't open %s: %s\n", name, strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	const char *strid = fs_params.prog.strid;
+	char        corpus_strid[256];
+	int         ret   = EXIT_SUCCESS;
+	for (int i = 0; ret == EXIT_SUCCESS; ++i) {
+		corpus_status_t status;
+		prog_t         *prog = load_corpus_prog(in, &status);
+		if (status == CORPUS_END) {
+			break;
+		} else if (status == CORPUS_STALE) {
+			fprintf(stderr, "%s: record %d was written by another generator version\n", name, i);
+			ret = EXIT_FAILURE;
+			break;
+		} else if (prog == NULL) {
+			fprintf(stderr, "%s: record %d is malformed\n", name, i);
+			ret = EXIT_FAILURE;
+			break;
+		}
+
+		snprintf(corpus_strid, sizeof corpus_strid, "%s-%d", strid, i);
+		fs_params.prog.strid = corpus_strid;
+		lower_prog(prog);
+		ret = process_prog(prog);
+	}
+	fs_params.prog.strid = strid;
+	fclose(in);
+	return ret;
+}
+
+/**
+ * Exports the current irp and returns the 64 bit FNV-1a hash of the text.
+ */
+static uint64_t hash_exported_ir(void) {
+	FILE *tmp = tmpfile();
+	if (tmp == NULL) {
+		fprintf(stderr, "couldn't create temporary file: %s\n", strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	ir_export_file(tmp);
+	rewind(tmp);
+
+	uint64_t hash = UINT64_C(0xcbf29ce484222325);
+	int      c;
+	while ((c = getc(tmp)) != EOF) {
+		hash ^= (unsigned char)c;
+		hash *= UINT64_C(0x100000001b3);
+	}
+	fclose(tmp);
+	return hash;
+}
+
+/**
+ * Generates the program of the current parameters twice and checks that
+ * both runs export the same IR, then checks that the program rebuilt from
+ * the corpus record of the first run exports it as well.
+ * Prints "<strid>\t<seed>\t<hash>".
+ */
+static int verify_determinism(void) {
+	FILE *record = tmpfile();
+	if (record == NULL) {
+		fprintf(stderr, "couldn't create temporary file: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	// Every build has to start from an empty irp like the second one does
+	reset_irp();
+
+	uint64_t hashes[3];
+	for (int i = 0; i < 2; ++i) {
+		gen_context_t *ctx  = initialize_prog();
+		prog_t        *prog = new_random_prog(ctx);
+		if (i == 0 && !corpus_write_prog(record, prog)) {
+			fprintf(stderr, "couldn't write the corpus record to a temporary file\n");
+			finish_prog(prog);
+			fclose(record);
+			return EXIT_FAILURE;
+		}
+		lower_prog(prog);
+		hashes[i] = hash_exported_ir();
+		finish_prog(prog);
+	}
+	if (hashes[0] != hashes[1]) {
+		fprintf(stderr, "%s: seed %d is not deterministic (%016" PRIx64 " != %016" PRIx64 ")\n",
+			fs_params.prog.strid, fs_params.prog.seed, hashes[0], hashes[1]);
+		fclose(record);
+		return EXIT_FAILURE;
+	}
+
+	rewind(record);
+	corpus_status_t status;
+	prog_t         *prog = load_corpus_prog(record, &status);
+	fclose(record);
+	if (prog == NULL) {
+		fprintf(stderr, "%s: seed %d couldn't be rebuilt from its corpus record\n",
+			fs_params.prog.strid, fs_params.prog.seed);
+		return EXIT_FAILURE;
+	}
+	lower_prog(prog);
+	hashes[2] = hash_exported_ir();
+	finish_prog(prog);
+	if (hashes[2] != hashes[0]) {
+		fprintf(stderr, "%s: seed %d changes through its corpus record (%016" PRIx64 " != %016" PRIx64 ")\n",
+			fs_params.prog.strid, fs_params.prog.seed, hashes[0], hashes[2]);
+		return EXIT_FAILURE;
+	}
+	printf("%s\t%d\t%016" PRIx64 "\n", fs_params.prog.strid, fs_params.prog.seed, hashes[0]);
 	return EXIT_SUCCESS;
 }
 
+static int action_run(const char *argv0) {
+	(void)argv0;
+	if (fs_params.run.corpus_in != NULL) {
+		return run_corpus();
+	}
+	if (fs_params.run.sweep > 0) {
+		FILE *stats_out = open_pass_stats();
+		if (fs_params.run.pass_stats != NULL && stats_out == NULL) {
+			return EXIT_FAILURE;
+		}
+		int ret = sweep_opts(build_prog, finish_prog, stats_out);
+		if (stats_out != NULL && stats_out != stdout) {
+			fclose(stats_out);
+		}
+		return ret;
+	}
+
+	int (*generate)(void) = fs_params.run.verify_determinism ?
+		verify_determinism : generate_prog;
+	if (fs_params.run.count == 1) {
+		return generate();
+	}
+
+	// Batch mode: program i is the one generated by --seed <seed>+i
+	int         seed  = fs_params.prog.seed;
+	const char *strid = fs_params.prog.strid;
+	char        batch_strid[256];
+	int         ret   = EXIT_SUCCESS;
+	for (int i = 0; i < fs_params.run.count && ret == EXIT_SUCCESS; ++i) {
+		snprintf(batch_strid, sizeof batch_strid, "%s-%d", strid, i);
+		fs_params.prog.seed  = seed + i;
+		fs_params.prog.strid = batch_strid;
+		ret = generate();
+	}
+	fs_params.prog.seed  = seed;
+	fs_params.prog.strid = strid;
+	return ret;
+}
+
 int main(int argc, char **argv)
 {
 
@@ -147,14 +521,25 @@ int main(int argc, char **argv)
 			state.argument_errors = true;
 		}
 	}
+	if (!check_ir_out()) {
+		state.argument_errors = true;
+	}
+	if (fs_params.run.count < 1) {
+		fprintf(stderr, "--count expects a positive number\n");
+		state.argument_errors = true;
+	}
+	if (!check_sweep()) {
+		state.argument_errors = true;
+	}
 	if (state.argument_errors) {
 		action_help(argv[0]);
 		return EXIT_FAILURE;
 	}
-	srand(fs_params.prog.seed);
 
 	assert(state.action != NULL);
-	int ret = state.action(argv[0]);
+	int ret = fs_params.run.server ?
+		serve_requests(argv[0], state.action) :
+		state.action(argv[0]);
 
 	finish_firmsmith();
 